@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "cinder/audio/Buffer.h"
+#include "CinderNDISender.h"
+
+class CinderNDIAudioPacketizer;
+using CinderNDIAudioPacketizerPtr = std::unique_ptr<CinderNDIAudioPacketizer>;
+
+// Cuts a continuous stream of samples into one audio frame per video frame. Frame sizes follow the exact cadence of the
+// video rate, 1601 and 1602 samples alternating in a five frame pattern at 48 kHz and 30000 / 1001, and every frame
+// carries the timecode of its video frame, so audio stays locked to video however long the sender runs.
+// Samples are buffered in storage allocated up front, writing and popping do not allocate unless the app writes more
+// than mMaxBufferedFrames ahead. Not thread safe.
+class CinderNDIAudioPacketizer {
+public:
+	struct Description {
+		int			mSampleRate{ DEFAULT_AUDIO_SAMPLE_RATE };
+		size_t		mNumChannels{ 2 };
+		int			mFrameRateNumerator{ DEFAULT_FRAMERATE_NUMERATOR };
+		int			mFrameRateDenomenator{ DEFAULT_FRAMERATE_DENOMENATOR };
+		int64_t		mStartTimecode{ 0 }; // Timecode of the first frame in 100 ns units.
+		size_t		mMaxBufferedFrames{ 4 }; // Video frames worth of samples preallocated.
+	};
+	CinderNDIAudioPacketizer( const Description& dscr );
+	// Appends numFrames samples of the buffer starting at offset. Missing channels are filled with silence.
+	void write( const ci::audio::Buffer& buffer, size_t numFrames, size_t offset = 0 );
+	// Returns the next frame once enough samples are buffered, or nullptr. The buffer is owned by the packetizer and valid
+	// until the next call, params receive the frame's sample rate and timecode for CinderNDISender::sendAudio().
+	ci::audio::Buffer* pop( CinderNDISender::AudioFrameParams* params = nullptr );
+	// Samples the next popped frame will hold, writing this many per video frame keeps the buffer from growing.
+	size_t getNextFrameSize() const;
+	// Timecode of the next popped frame, pass it with the matching video frame to keep the two aligned.
+	int64_t getNextTimecode() const;
+	uint64_t getFrameIndex() const { return mFrameIndex; }
+	size_t getNumBufferedSamples() const { return mNumBuffered; }
+	// Drops buffered samples and restarts the cadence from mStartTimecode.
+	void reset();
+	const Description& getDescription() const { return mDescription; }
+private:
+	// First sample of the frame, counted from the start of the stream.
+	int64_t getSamplePosition( uint64_t frameIndex ) const;
+	void reserve( size_t numFrames );
+private:
+	Description						mDescription;
+	ci::audio::BufferDynamic		mBuffered; // One channel after the other, mCapacity samples each.
+	ci::audio::BufferDynamic		mFrame;
+	size_t							mCapacity{ 0 };
+	size_t							mNumBuffered{ 0 };
+	uint64_t						mFrameIndex{ 0 };
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "cinder/Surface.h"
+
+// Halves the surface in width and height with a 2x2 box filter, SIMD accelerated for 4 bytes per pixel.
+// dst must use the same pixel layout and be at least half the size of src, odd trailing rows and columns are dropped.
+void downscaleNDISurfaceByHalf( const ci::Surface8u& src, ci::Surface8u* dst );
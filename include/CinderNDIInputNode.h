@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+#include "cinder/audio/InputNode.h"
+
+class CinderNDIReceiver;
+
+class CinderNDIInputNode;
+using CinderNDIInputNodeRef = std::shared_ptr<CinderNDIInputNode>;
+
+// Audio graph source fed by a CinderNDIReceiver, samples are copied once from the receiver's jitter buffer into the
+// node's output. Works with any block size and maps the received channels onto the node's channels.
+// Created through the audio context, e.g. ci::audio::master()->makeNode( new CinderNDIInputNode( receiver ) ).
+// The receiver has to outlive the node, or the node has to be disabled before the receiver is destroyed.
+class CinderNDIInputNode : public ci::audio::InputNode {
+public:
+	CinderNDIInputNode( CinderNDIReceiver* receiver, const Format& format = Format() );
+	std::string getName() const override { return "CinderNDIInputNode"; }
+	CinderNDIReceiver* getReceiver() const { return mReceiver; }
+protected:
+	void process( ci::audio::Buffer* buffer ) override;
+private:
+	CinderNDIReceiver*	mReceiver;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+// Keeps the fill of an audio jitter buffer at a target latency. The fill is measured after every write and smoothed,
+// a PI controller turns the deviation into a small playback ratio correction that is applied through the resampler.
+// In steady state the integral part equals the clock drift between sender and audio device.
+// Not thread safe, lives on the receive side.
+class CinderNDILatencyController {
+public:
+	struct Format {
+		float	mTargetLatency{ 50.0f }; // Milliseconds.
+		float	mMaxCorrection{ 1000.0f }; // Parts per million, bounds the audible pitch shift.
+		float	mSmoothing{ 2.0f }; // Seconds, time constant of the fill average.
+		float	mResponseTime{ 30.0f }; // Seconds to work off a latency error through the proportional part.
+		float	mDriftTime{ 300.0f }; // Seconds, integration time constant of the drift estimate.
+	};
+	CinderNDILatencyController( const Format& format );
+	// Target in frames for the given rate, never below minFrames.
+	size_t getTargetFrames( double sampleRate, size_t minFrames ) const;
+	// Feeds the fill after writing numFrames at sampleRate.
+	void update( size_t fillFrames, size_t numFrames, size_t targetFrames, double sampleRate );
+	// Restarts the fill average from the target, e.g. after the buffer has been primed or frames have been skipped.
+	void reset( size_t targetFrames );
+
+	// Relative ratio correction to apply to the input step, positive when the buffer is too full.
+	double getCorrection() const { return mCorrection; }
+	float getLatency() const { return mLatency; } // Milliseconds, smoothed.
+	float getDriftPpm() const { return float( mIntegral * 1.0e6 ); }
+private:
+	Format	mFormat;
+	double	mSmoothedFill{ -1.0 };
+	double	mIntegral{ 0.0 };
+	double	mCorrection{ 0.0 };
+	float	mLatency{ 0.0f };
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Fixed size, wait-free latency histogram cheap enough to record every frame of every receiver.
+// Buckets grow in quarter powers of two from 1 microsecond up to roughly a minute, so percentiles are
+// reported with about 12% resolution. Recording and reading may happen concurrently from any thread.
+class CinderNDILatencyHistogram {
+public:
+	// All values in milliseconds.
+	struct Summary {
+		uint64_t	mCount{ 0 };
+		float		mP50{ 0.0f };
+		float		mP99{ 0.0f };
+		float		mMax{ 0.0f };
+	};
+	CinderNDILatencyHistogram();
+	void record( float milliseconds );
+	template<typename Rep, typename Period>
+	void record( std::chrono::duration<Rep, Period> duration ) { record( std::chrono::duration<float, std::milli>( duration ).count() ); }
+	Summary getSummary() const;
+	void reset();
+private:
+	static const size_t NUM_BUCKETS = 104;
+	static size_t getBucket( uint32_t microseconds );
+	static float getBucketCenter( size_t bucket );
+private:
+	std::array<std::atomic<uint64_t>, NUM_BUCKETS>	mBuckets;
+	std::atomic<uint32_t>							mMaxMicroseconds{ 0 };
+};
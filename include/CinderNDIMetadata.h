@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include "Processing.NDI.Lib.h"
+#include "CinderNDISpscQueue.h"
+
+// A metadata frame copied out of the SDK.
+struct CinderNDIMetadataFrame {
+	std::string		mData; // UTF8 XML.
+	int64_t			mTimecode{ 0 }; // In 100ns intervals.
+};
+
+using CinderNDIMetadataQueue = CinderNDISpscQueue<CinderNDIMetadataFrame>;
+using CinderNDIMetadataQueuePtr = std::unique_ptr<CinderNDIMetadataQueue>;
+
+// Non owning view into the XML text, valid as long as the text it was parsed from.
+struct CinderNDIXmlString {
+	const char*		mData{ nullptr };
+	size_t			mSize{ 0 };
+
+	bool operator==( const char* str ) const;
+	bool operator!=( const char* str ) const { return ! ( *this == str ); }
+	bool empty() const { return mSize == 0; }
+	std::string str() const { return std::string( mData, mSize ); }
+	// Numeric conversions without allocating. Return false if the whole string is not a number.
+	bool toInt( int64_t* value ) const;
+	bool toDouble( double* value ) const;
+	// Resolves entity and character references into out, which gets null terminated.
+	// Returns the decoded length, or the length that would be needed if capacity is too small.
+	size_t decode( char* out, size_t capacity ) const;
+};
+
+// Streaming pull parser for the elements and attributes of NDI metadata. It walks the text in place without building
+// a tree or allocating: names and values are views into the text, attribute values are raw ( see CinderNDIXmlString::decode ).
+// Text content, comments, processing instructions and CDATA sections are skipped.
+//
+//	CinderNDIXmlReader reader( frame.mData );
+//	while( reader.nextElement() ) {
+//		if( reader.getElementName() == "tracking" ) {
+//			while( reader.nextAttribute() ) { ... }
+//		}
+//	}
+class CinderNDIXmlReader {
+public:
+	CinderNDIXmlReader( const char* data, size_t size );
+	explicit CinderNDIXmlReader( const std::string& xml ) : CinderNDIXmlReader( xml.data(), xml.size() ) {}
+	// Advances to the next start tag, skipping the remaining attributes of the current one.
+	// Returns false at the end of the text or on malformed input.
+	bool nextElement();
+	// Advances to the next attribute of the current element. Returns false once the tag is closed.
+	bool nextAttribute();
+	// Advances through the attributes of the current element until name is found. Attributes are consumed in document
+	// order, so look them up in the order they appear or iterate with nextAttribute().
+	bool findAttribute( const char* name, CinderNDIXmlString* value );
+
+	const CinderNDIXmlString& getElementName() const { return mElementName; }
+	const CinderNDIXmlString& getAttributeName() const { return mAttributeName; }
+	const CinderNDIXmlString& getAttributeValue() const { return mAttributeValue; }
+	// Nesting depth of the current element, the root element is at depth 0.
+	size_t getDepth() const { return mDepth; }
+	// True for <element/>, known once the attributes have been read.
+	bool isEmptyElement() const { return mEmptyElement; }
+	bool hasError() const { return mError; }
+private:
+	void closeTag( bool empty );
+	void fail();
+	bool skipPast( const char* terminator );
+private:
+	const char*			mCursor;
+	const char*			mEnd;
+	CinderNDIXmlString	mElementName;
+	CinderNDIXmlString	mAttributeName;
+	CinderNDIXmlString	mAttributeValue;
+	size_t				mDepth{ 0 };
+	size_t				mOpenElements{ 0 };
+	bool				mInTag{ false };
+	bool				mEmptyElement{ false };
+	bool				mError{ false };
+};
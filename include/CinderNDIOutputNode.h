@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cinder/audio/Node.h"
+#include "cinder/audio/dsp/RingBuffer.h"
+
+class CinderNDISender;
+
+class CinderNDIOutputNode;
+using CinderNDIOutputNodeRef = std::shared_ptr<CinderNDIOutputNode>;
+
+// Audio graph tap feeding a CinderNDISender, the counterpart of CinderNDIInputNode. Blocks pass through unchanged and
+// are copied into lock-free ring buffers on the audio thread, a sender thread batches them into packets of
+// framesPerPacket samples, 10 ms when 0, and sends those. The audio thread never waits on the network, it only wakes
+// the sender thread once a packet is ready, blocks that do not fit because sending stalled are dropped and counted. Like ci::audio::MonitorNode the node is pulled by the
+// context when nothing is connected to its output.
+// Created through the audio context, e.g. ci::audio::master()->makeNode( new CinderNDIOutputNode( sender ) ).
+// The sender has to outlive the node, or the node has to be disabled and uninitialized before the sender is destroyed.
+class CinderNDIOutputNode : public ci::audio::NodeAutoPullable {
+public:
+	CinderNDIOutputNode( CinderNDISender* sender, const Format& format = Format(), size_t framesPerPacket = 0 );
+	~CinderNDIOutputNode();
+	std::string getName() const override { return "CinderNDIOutputNode"; }
+	CinderNDISender* getSender() const { return mSender; }
+	size_t getFramesPerPacket() const { return mFramesPerPacket; }
+	uint64_t getNumOverruns() const { return mNumOverruns; }
+	// Stops the sender thread, public so the node can be shut down ahead of the sender it feeds.
+	void uninitialize() override;
+protected:
+	void initialize() override;
+	void process( ci::audio::Buffer* buffer ) override;
+private:
+	void sendThread();
+	void stopSendThread();
+private:
+	CinderNDISender*						mSender;
+	size_t									mFramesPerPacketRequested;
+	size_t									mFramesPerPacket{ 0 };
+	size_t									mSampleRate{ 0 };
+	std::vector<ci::audio::dsp::RingBuffer>	mRingBuffers;
+	ci::audio::BufferDynamic				mPacket;
+	std::unique_ptr<std::thread>			mSendThread;
+	std::mutex								mSendMutex;
+	std::condition_variable					mSendCondition;
+	std::atomic<bool>						mSendThreadExiting{ false };
+	std::atomic<uint64_t>					mNumOverruns{ 0 };
+};
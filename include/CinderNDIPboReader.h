@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Sync.h"
+#include "CinderNDISurfacePool.h"
+#include "CinderNDILatencyHistogram.h"
+
+class CinderNDIPboReader;
+using CinderNDIPboReaderPtr = std::unique_ptr<CinderNDIPboReader>;
+
+// Reads textures back into CPU side surfaces through a ring of pixel-pack buffers, the counterpart of CinderNDIPboUploader.
+// Each readback is fenced and its buffer only mapped once the fence has signaled, so the GPU is never waited on
+// unless every buffer of the ring is in flight. Rows are flipped for bottom up textures and swizzled into BGRA while
+// copying out of the mapped buffer. GL objects are created on first use, after that the reader must be used and destroyed
+// on the thread that owns the current GL context.
+class CinderNDIPboReader {
+public:
+	CinderNDIPboReader( size_t ringSize, const CinderNDISurfacePoolRef& surfacePool );
+	~CinderNDIPboReader();
+	// Schedules the readback of the texture's first mip level. Returns false if every buffer of the ring is still pending.
+	bool read( const ci::gl::TextureRef& texture );
+	// Returns the oldest readback once the GPU is done with it, or nullptr if none is ready yet.
+	// With wait the call blocks until it is done instead.
+	ci::Surface8uRef popCompleted( bool wait = false );
+	bool hasPending() const { return ! mPending.empty(); }
+	size_t getNumPending() const { return mPending.size(); }
+	bool isFull() const { return mPending.size() == mSlots.size(); }
+	// Time spent waiting on the GPU and mapping per frame, and copying the mapped pixels into a surface.
+	CinderNDILatencyHistogram::Summary getStallSummary() const { return mStallHistogram.getSummary(); }
+	CinderNDILatencyHistogram::Summary getCopySummary() const { return mCopyHistogram.getSummary(); }
+	void resetStats();
+private:
+	struct Slot {
+		GLuint				mPbo{ 0 };
+		size_t				mCapacity{ 0 };
+		int					mWidth{ 0 };
+		int					mHeight{ 0 };
+		bool				mFlip{ false };
+		ci::gl::SyncRef		mFence;
+	};
+private:
+	std::vector<Slot>				mSlots;
+	std::deque<size_t>				mPending;
+	size_t							mNextSlot{ 0 };
+	GLuint							mFramebuffer{ 0 };
+	CinderNDISurfacePoolRef			mSurfacePool;
+	CinderNDILatencyHistogram		mStallHistogram;
+	CinderNDILatencyHistogram		mCopyHistogram;
+};
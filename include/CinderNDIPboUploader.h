@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Sync.h"
+#include "CinderNDITexturePool.h"
+#include "CinderNDIVideoFormat.h"
+
+class CinderNDIPboUploader;
+using CinderNDIPboUploaderPtr = std::unique_ptr<CinderNDIPboUploader>;
+
+// Streams CPU side pixels into reused textures through a ring of pixel-unpack buffers.
+// Buffers are persistently mapped when the context supports GL_ARB_buffer_storage and mapped unsynchronized
+// on every upload otherwise. Completion is tracked with fences that are only ever polled, never waited on.
+// Must be created, used and destroyed on the thread that owns the current GL context.
+class CinderNDIPboUploader {
+public:
+	CinderNDIPboUploader( size_t ringSize, const CinderNDITexturePoolRef& texturePool );
+	~CinderNDIPboUploader();
+	// Copies the pixels into the next free buffer and schedules the transfer into a texture described by the layout.
+	// Returns false if every buffer of the ring is still in flight, in which case the frame is dropped.
+	bool upload( const uint8_t* data, const CinderNDITextureLayout& layout, int rowBytes );
+	// Returns the oldest texture whose transfer has completed on the GPU, or nullptr if none is ready yet.
+	ci::gl::TextureRef popCompleted();
+	bool hasPending() const { return ! mPending.empty(); }
+	bool isPersistentlyMapped() const { return mPersistentMapping; }
+private:
+	struct Slot {
+		GLuint				mPbo{ 0 };
+		size_t				mCapacity{ 0 };
+		uint8_t*			mMappedData{ nullptr };
+		ci::gl::SyncRef		mFence;
+		ci::gl::TextureRef	mTexture;
+	};
+	void				allocate( Slot& slot, size_t size );
+	void				release( Slot& slot );
+private:
+	std::vector<Slot>				mSlots;
+	std::deque<size_t>				mPending;
+	size_t							mNextSlot{ 0 };
+	bool							mPersistentMapping{ false };
+	CinderNDITexturePoolRef			mTexturePool;
+};
@@ -1,26 +1,45 @@
 #pragma once
 
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "cinder/gl/Texture.h"
 #include "cinder/gl/Context.h"
 #include "cinder/ConcurrentCircularBuffer.h"
 #include "cinder/audio/Buffer.h"
 #include "cinder/audio/dsp/RingBuffer.h"
 #include "CinderNDIFinder.h"
+#include "CinderNDIPboUploader.h"
+#include "CinderNDITexturePool.h"
+#include "CinderNDISurfacePool.h"
+#include "CinderNDIVideoFormat.h"
+#include "CinderNDIVideoFrame.h"
+#include "CinderNDIVideoQueue.h"
+#include "CinderNDILatencyHistogram.h"
+#include "CinderNDIResampler.h"
+#include "CinderNDILatencyController.h"
+#include "CinderNDIReceiverPool.h"
+#include "CinderNDIMetadata.h"
 
 class CinderNDIReceiver;
 using CinderNDIReceiverPtr = std::unique_ptr<CinderNDIReceiver>;
 
 using NDIReceiverPtr = NDIlib_recv_instance_t;
 
-using VideoFramesBuffer = ci::ConcurrentCircularBuffer<ci::gl::TextureRef>;
-using VideoFramesBufferPtr = std::unique_ptr<VideoFramesBuffer>;
+using VideoFramesBuffer = CinderNDIVideoQueue;
+using VideoFramesBufferPtr = CinderNDIVideoQueuePtr;
 
 using AudioFramesBuffer = ci::ConcurrentCircularBuffer<ci::audio::BufferRef>;
 using AudioFramesBufferPtr = std::unique_ptr<AudioFramesBuffer>;
 
 class CinderNDIReceiver{
 public:
+	enum State {
+		STOPPED,
+		RUNNING,
+		EXITING
+	};
 	enum Bandwidth {
 		METADATA_ONLY = NDIlib_recv_bandwidth_metadata_only,
 		AUDIO_ONLY = NDIlib_recv_bandwidth_audio_only,
@@ -34,35 +53,212 @@ public:
 		UYVY_RGBA = NDIlib_recv_color_format_UYVY_RGBA,
 		FASTEST = NDIlib_recv_color_format_fastest
 	};
+	enum UploadMode {
+		SYNCHRONOUS, // Uploads every frame straight into a pooled texture and waits for the upload to finish.
+		PBO_RING // Streams frames through a ring of pixel-unpack buffers into reused textures without waiting on the GPU.
+	};
+	enum VideoOutput {
+		TEXTURE, // Frames are uploaded on a shared GL context and read through getVideoTexture().
+		SURFACE, // Frames are copied into pooled surfaces and read through getVideoSurface(), GL is never touched.
+		FRAME // Frames are handed out in place through getVideoFrame() without any copy, GL is never touched.
+	};
 	struct Description {
 		ColorFormat mColorFormat{ RGBX_RGBA };
 		Bandwidth mBandwidth{ HIGHEST };
 		bool mAllowVideoFields{ false };
 		const NDISource* source{ nullptr }; // Owened by NDIlib_find
 		std::string mName;
+		UploadMode mUploadMode{ SYNCHRONOUS };
+		size_t mPboRingSize{ 3 }; // Number of pixel-unpack buffers in flight when using PBO_RING.
+		VideoOutput mVideoOutput{ TEXTURE };
+		size_t mMaxFramesInFlight{ 4 }; // Frames held outside the SDK with VideoOutput::FRAME or mLazyUpload, queued ones included.
+		CinderNDIVideoQueue::Format mVideoQueue; // Latency policy of the queue between the receive thread and the getVideo* calls.
+		// With VideoOutput::TEXTURE, keep frames on the CPU and upload only the one getVideoTexture() returns, on the calling thread.
+		// Upload cost then follows the display rate instead of the source rate. Combine with a MAILBOX queue to always show the newest frame.
+		bool mLazyUpload{ false };
+		bool mAutoStart{ true }; // Start receiving right away, otherwise wait for start().
+		// Capture on the workers of a shared pool instead of on two threads owned by the receiver. The pool must outlive the receiver.
+		// Textures are then uploaded on the pool's upload context and mUploadMode is ignored.
+		CinderNDIReceiverPool* mReceiverPool{ nullptr };
+		// Convert audio from the sender's sample rate to the rate of the audio context on the receive thread.
+		bool mResampleAudio{ true };
+		CinderNDIResampler::Quality mResampleQuality{ CinderNDIResampler::MEDIUM };
+		// Target latency of the audio jitter buffer and how quickly it is approached, see CinderNDILatencyController.
+		CinderNDILatencyController::Format mAudioLatency;
+		// Hold the jitter buffer at its target by resampling slightly, compensating drift between the sender's clock and the
+		// audio device. Audio then always goes through the resampler, even if both rates match.
+		bool mAudioDriftCompensation{ true };
+		size_t mMetadataQueueSize{ 64 }; // Metadata frames kept for getMetadataFrame() before new ones are dropped.
+	};
+	// Snapshot returned by getStats(). SDK counters are totals since the receiver was created.
+	struct Stats {
+		int64_t		mNumVideoFramesReceived{ 0 };
+		int64_t		mNumAudioFramesReceived{ 0 };
+		int64_t		mNumMetadataFramesReceived{ 0 };
+		int64_t		mNumVideoFramesDroppedBySDK{ 0 };
+		int64_t		mNumAudioFramesDroppedBySDK{ 0 };
+		int64_t		mNumMetadataFramesDroppedBySDK{ 0 };
+		// Frames waiting inside the SDK to be captured, a growing number means capture is falling behind.
+		int			mNumVideoFramesQueuedBySDK{ 0 };
+		int			mNumAudioFramesQueuedBySDK{ 0 };
+		int			mNumMetadataFramesQueuedBySDK{ 0 };
+		uint64_t	mNumVideoFramesDropped{ 0 };
+		uint64_t	mNumVideoFramesRepeated{ 0 };
+		size_t		mVideoQueueDepth{ 0 };
+		size_t		mNumVideoFramesInFlight{ 0 };
+		uint64_t	mNumAudioUnderruns{ 0 };
+		uint64_t	mNumAudioOverruns{ 0 };
+		uint64_t	mNumAudioResyncs{ 0 }; // Jitter buffer refilled with silence or frames skipped to get back to the target.
+		float		mAudioLatency{ 0.0f }; // Milliseconds buffered between the receive side and getAudioBuffer().
+		float		mAudioDriftPpm{ 0.0f }; // Estimated clock drift, positive when the sender runs fast.
+		float		mAudioCorrectionPpm{ 0.0f }; // Ratio correction currently applied.
+		double		mAudioCorrectionFrames{ 0.0 }; // Net frames added ( positive ) or removed by the correction so far.
+		// Per stage latencies of received video frames.
+		CinderNDILatencyHistogram::Summary	mCaptureWait; // Time spent inside the capture call that returned the frame.
+		CinderNDILatencyHistogram::Summary	mWrap; // Wrapping the SDK buffer into a frame, or copying it into a surface with VideoOutput::SURFACE.
+		CinderNDILatencyHistogram::Summary	mTextureCreate; // Acquiring a pooled texture and issuing the upload.
+		CinderNDILatencyHistogram::Summary	mFenceWait; // Waiting for a synchronous upload to land on the GPU.
+		CinderNDILatencyHistogram::Summary	mQueueResidence; // Time between a frame being queued and picked up by getVideo*.
+		CinderNDILatencyHistogram::Summary	mAudioResample; // Sample rate conversion of one channel of a received audio frame.
 	};
 	CinderNDIReceiver( const Description dscr );
 	~CinderNDIReceiver();
 	void connect( const NDISource& source );
+	// Disconnects from the current source and drops any frames still queued from it.
 	void disconnect();
+	// Resumes / parks the receive threads. A stopped receiver keeps its SDK instance, connection and GL resources
+	// so it can be started again cheaply. Both return without waiting on the threads.
+	void start();
+	void stop();
+	bool isRunning() const { return mState == RUNNING; }
 	ci::gl::TextureRef getVideoTexture();
+	// Only available with VideoOutput::SURFACE. Surfaces use the same layout as textures, see CinderNDITextureLayout.
+	ci::Surface8uRef getVideoSurface();
+	// Only available with VideoOutput::FRAME. The SDK buffer is released when the last reference is dropped.
+	NDIVideoFrameRef getVideoFrame();
+	// FourCC and resolution of the frame last returned by getVideoTexture() / getVideoSurface() / getVideoFrame().
+	// UYVY / UYVA textures need to be drawn through CinderNDIYUVDecoder.
+	NDIlib_FourCC_type_e getVideoFourCC() const { return mCurrentVideoFrame.mFourCC; }
+	ci::ivec2 getVideoSize() const { return mCurrentVideoFrame.mSize; }
+	int64_t getVideoTimecode() const { return mCurrentVideoFrame.mTimecode; }
+	// XML metadata sent along with the current frame, empty if there was none. Parse with CinderNDIXmlReader.
+	// Valid until the next getVideo* call.
+	const char* getVideoMetadata() const;
+	// Meant to be called from the audio callback. Never locks or allocates, the buffer is reused across calls and is
+	// zeroed when not enough samples have been received. Returns nullptr until the first audio frame arrives.
 	ci::audio::BufferRef getAudioBuffer();
+	// Fills all frames of buffer, whatever their number, mapping the received channels onto the channels of buffer.
+	// Same guarantees as getAudioBuffer(), but copies straight into the caller's buffer. Use either one of them, not both.
+	// Returns false and zeroes buffer if not enough samples have been received.
+	bool readAudio( ci::audio::Buffer* buffer );
+	// Calls to getAudioBuffer() / readAudio() that ran dry and received audio frames that did not fit into the ring buffers.
+	uint64_t getNumAudioUnderruns() const { return mNumAudioUnderruns; }
+	uint64_t getNumAudioOverruns() const { return mNumAudioOverruns; }
+	// CPU time in milliseconds spent uploading ( or copying with VideoOutput::SURFACE ) the last received video frame.
+	// With mLazyUpload this is the time getVideoTexture() spent on its upload.
+	float getVideoUploadTime() const { return mVideoUploadTime; }
+	// Textures handed out by getVideoTexture() are recycled through this pool once released.
+	const CinderNDITexturePoolRef& getTexturePool() const { return mTexturePool; }
+	const CinderNDISurfacePoolRef& getSurfacePool() const { return mSurfacePool; }
+	// Frames dropped by the video queue policy, calls to getVideo* that found no new frame and frames currently queued.
+	uint64_t getNumVideoFramesDropped() const { return mVideoFramesBuffer->getNumDropped(); }
+	uint64_t getNumVideoFramesRepeated() const { return mNumVideoFramesRepeated; }
+	size_t getVideoQueueDepth() const { return mVideoFramesBuffer->getDepth(); }
+	size_t getNumVideoFramesInFlight() const { return mFrameTracker ? mFrameTracker->getNumFramesInFlight() : 0; }
+	// Cheap enough to poll every frame, histograms are wait-free and the SDK queries do not block capture.
+	Stats getStats() const;
+	// Clears the latency histograms, the repeated frame counter and the audio underrun / overrun counters.
+	void resetStats();
+	// Pops the oldest standalone metadata frame, returns false if there is none. Parse with CinderNDIXmlReader.
+	// Metadata is captured by the audio thread, or by a thread of its own with Bandwidth::METADATA_ONLY.
+	// The previous contents of frame are recycled by the receiver, so passing the same frame every time avoids allocations.
+	bool getMetadataFrame( CinderNDIMetadataFrame* frame );
+	uint64_t getNumMetadataFramesDropped() const { return mNumMetadataFramesDropped; }
+	bool receivesVideo() const { return mReceiverDescription.mBandwidth != AUDIO_ONLY && mReceiverDescription.mBandwidth != METADATA_ONLY; }
+	bool receivesAudio() const { return mReceiverDescription.mBandwidth != METADATA_ONLY; }
+	// Average milliseconds a pool worker spends per pass on this receiver, video and audio capture combined. Zero without a pool.
+	float getPoolServiceTime() const;
 private:
+	friend class CinderNDIReceiverPool;
+	// Blocks while the receiver is stopped. Returns false once the receiver is being destroyed.
+	bool waitUntilRunning();
 	void videoRecvThread( ci::gl::ContextRef ctx );
-	void receiveVideo();
+	void receiveVideo( uint32_t timeout );
+	void uploadVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout );
+	void copyVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout );
+	bool popVideoFrame();
+	// Hands over a texture uploaded by the receiver pool.
+	void deliverVideoFrame( const CinderNDIVideoQueueEntry& entry, float uploadTime );
+	static ci::gl::TextureRef uploadToPooledTexture( const CinderNDITexturePoolRef& texturePool, const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout );
 	void audioRecvThread();
-	void receiveAudio();
+	void receiveAudio( uint32_t timeout );
+	// Ring buffers and output buffer for one channel layout. A new one is published to the audio thread whenever the layout changes.
+	struct AudioStream {
+		ci::audio::BufferRef					mBuffer;
+		size_t									mTargetFrames{ 0 };
+		std::vector<float>						mScratch; // Used by the audio thread when downmixing.
+		std::vector<ci::audio::dsp::RingBuffer>	mRingBuffers;
+	};
+	// Picks up the newest stream. Audio thread only.
+	AudioStream* acquireAudioStream();
+	// Deletes the streams the audio thread has moved past. Receive side only.
+	void releaseAudioStreams();
+	void metadataRecvThread();
+	void receiveMetadata( uint32_t timeout );
+	void queueMetadata( const NDIlib_metadata_frame_t& metadataFrame );
+	static void describeVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, bool copyMetadata, CinderNDIVideoQueueEntry* entry );
+	// Resamples the channels in mAudioChannelData and points them at the converted frames. Returns the new frame count.
+	size_t resampleAudio( size_t numChannels, size_t numFrames, int inputRate, size_t outputRate );
+	// Writes mAudioChannelData into the jitter buffer, priming or skipping to stay near the target latency.
+	void writeAudio( AudioStream* stream, size_t numChannels, size_t numFrames, size_t targetFrames, size_t sampleRate );
 private:
 	NDIReceiverPtr					mNDIReceiver;
+	NDIReceiverInstanceRef			mNDIReceiverInstance;
+	Description						mReceiverDescription;
 
 	VideoFramesBufferPtr			mVideoFramesBuffer;
 	std::unique_ptr<std::thread> 	mVideoRecvThread;
-	ci::gl::TextureRef				mVideoTexture;
+	CinderNDIVideoQueueEntry		mCurrentVideoFrame;
+	CinderNDITexturePoolRef			mTexturePool;
+	CinderNDISurfacePoolRef			mSurfacePool;
+	CinderNDIVideoFrameTrackerRef	mFrameTracker;
+	CinderNDIPboUploaderPtr			mPboUploader;
+	std::deque<CinderNDIVideoQueueEntry>	mPendingUploads;
+	std::atomic<float>				mVideoUploadTime{ 0.0f };
+	std::atomic<uint64_t>			mNumVideoFramesRepeated{ 0 };
+	CinderNDILatencyHistogram		mCaptureWaitHistogram;
+	CinderNDILatencyHistogram		mWrapHistogram;
+	CinderNDILatencyHistogram		mTextureCreateHistogram;
+	CinderNDILatencyHistogram		mFenceWaitHistogram;
+	CinderNDIReceiverPool::JobRef	mPoolVideoJob;
+	CinderNDIReceiverPool::JobRef	mPoolAudioJob;
+	CinderNDIReceiverPool::JobRef	mPoolMetadataJob;
 	
 	std::unique_ptr<std::thread> 	mAudioRecvThread;
-	ci::audio::BufferRef			mCurrentAudioBuffer;
-	std::vector<ci::audio::dsp::RingBuffer> 		mRingBuffers;
-	std::mutex						mAudioMutex;
-	bool							mExitVideoThread{ false };
-	bool							mExitAudioThread{ false };
+	// Streams are created and deleted on the receive side only, newest last. The audio thread acknowledges the stream it
+	// reads from, every stream older than that one is never touched again and can be deleted.
+	std::vector<std::unique_ptr<AudioStream>>	mAudioStreams;
+	std::atomic<AudioStream*>		mPublishedAudioStream{ nullptr };
+	std::atomic<AudioStream*>		mAcquiredAudioStream{ nullptr };
+	AudioStream*					mCurrentAudioStream{ nullptr }; // Audio thread only.
+	std::atomic<uint64_t>			mNumAudioUnderruns{ 0 };
+	std::atomic<uint64_t>			mNumAudioOverruns{ 0 };
+	std::vector<const float*>		mAudioChannelData; // Receive side only, like the resampler state.
+	CinderNDIResamplerPtr			mResampler;
+	std::vector<float>				mResampledAudio;
+	CinderNDILatencyHistogram		mResampleHistogram;
+	CinderNDILatencyController		mLatencyController;
+	std::vector<float>				mSilence;
+	std::atomic<uint64_t>			mNumAudioResyncs{ 0 };
+	std::atomic<float>				mAudioLatency{ 0.0f };
+	std::atomic<float>				mAudioDriftPpm{ 0.0f };
+	std::atomic<float>				mAudioCorrectionPpm{ 0.0f };
+	std::atomic<double>				mAudioCorrectionFrames{ 0.0 };
+
+	std::unique_ptr<std::thread>	mMetadataRecvThread;
+	CinderNDIMetadataQueuePtr		mMetadataQueue;
+	std::atomic<uint64_t>			mNumMetadataFramesDropped{ 0 };
+	std::atomic<State>				mState{ STOPPED };
+	std::mutex						mStateMutex;
+	std::condition_variable			mStateCond;
 };
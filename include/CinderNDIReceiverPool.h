@@ -0,0 +1,97 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include "cinder/gl/Context.h"
+#include "CinderNDIVideoFrame.h"
+
+class CinderNDIReceiver;
+
+class CinderNDIReceiverPool;
+using CinderNDIReceiverPoolPtr = std::unique_ptr<CinderNDIReceiverPool>;
+
+// Services the capture of many receivers on a fixed number of worker threads instead of two threads per receiver.
+// Receivers join the pool through CinderNDIReceiver::Description::mReceiverPool. Workers take turns on them round-robin,
+// capturing with a short timeout, and all texture uploads go through one shared upload context on a dedicated thread.
+// The pool has to outlive every receiver that uses it.
+class CinderNDIReceiverPool {
+public:
+	struct Description {
+		size_t		mNumWorkers{ std::max<size_t>( std::thread::hardware_concurrency() / 2, 1 ) };
+		uint32_t	mCaptureTimeout{ 2 }; // Milliseconds a worker waits on a single receiver before moving on.
+		bool		mUploadTextures{ true }; // Create the shared upload context, needed by receivers with VideoOutput::TEXTURE.
+	};
+	struct Stats {
+		size_t		mNumReceivers{ 0 };
+		size_t		mNumWorkers{ 0 };
+		uint64_t	mNumServiced{ 0 }; // Capture passes run by the workers.
+		float		mAverageSchedulingLatency{ 0.0f }; // Milliseconds a receiver waited for a free worker.
+		float		mMaxSchedulingLatency{ 0.0f };
+		float		mAverageUploadBatchTime{ 0.0f }; // Milliseconds the upload thread spent per batch, fence wait included.
+		size_t		mUploadQueueDepth{ 0 };
+	};
+	// A receiver's capture of one media type, scheduled as a unit.
+	struct Job {
+		enum Kind { VIDEO, AUDIO, METADATA };
+		CinderNDIReceiver*						mReceiver{ nullptr }; // Cleared once the receiver leaves the pool.
+		Kind									mKind{ VIDEO };
+		bool									mRemoved{ false }; // Guarded by the pool mutex.
+		std::mutex								mMutex; // Held by the worker servicing the job.
+		std::mutex								mDeliveryMutex; // Held by the upload thread while it hands textures to the receiver.
+		std::chrono::steady_clock::time_point	mReadyTime;
+		std::atomic<float>						mAverageServiceTime{ 0.0f };
+	};
+	using JobRef = std::shared_ptr<Job>;
+
+	CinderNDIReceiverPool( const Description& dscr );
+	~CinderNDIReceiverPool();
+
+	Stats getStats() const;
+	// Resets the maximum scheduling latency reported by getStats().
+	void resetMaxSchedulingLatency() { mMaxSchedulingLatency = 0.0f; }
+private:
+	friend class CinderNDIReceiver;
+	// Jobs start out parked, no worker touches the receiver before resume() puts them into rotation.
+	JobRef	add( CinderNDIReceiver* receiver, Job::Kind kind );
+	// Blocks until no worker is servicing the receiver anymore.
+	void	remove( CinderNDIReceiver* receiver );
+	// Puts the jobs of a receiver that has been started again back into rotation.
+	void	resume( CinderNDIReceiver* receiver );
+	void	queueUpload( const JobRef& job, const NDIVideoFrameRef& frame );
+	bool	hasUploadContext() const { return mUploadThread != nullptr; }
+	// Expects mMutex to be held.
+	size_t	getNumReceivers() const;
+
+	void	workerThread();
+	void	uploadThread( ci::gl::ContextRef ctx );
+private:
+	struct Upload {
+		JobRef				mJob;
+		NDIVideoFrameRef	mFrame;
+	};
+	Description							mDescription;
+
+	mutable std::mutex					mMutex;
+	std::condition_variable				mRunQueueCond;
+	std::vector<JobRef>					mJobs;
+	std::deque<JobRef>					mRunQueue;
+	std::vector<JobRef>					mParkedJobs;
+	std::atomic<bool>					mExiting{ false };
+	std::vector<std::thread>			mWorkers;
+
+	mutable std::mutex					mUploadMutex;
+	std::condition_variable				mUploadCond;
+	std::deque<Upload>					mUploads;
+	std::unique_ptr<std::thread>		mUploadThread;
+
+	std::atomic<uint64_t>				mNumServiced{ 0 };
+	std::atomic<float>					mAverageSchedulingLatency{ 0.0f };
+	std::atomic<float>					mMaxSchedulingLatency{ 0.0f };
+	std::atomic<float>					mAverageUploadBatchTime{ 0.0f };
+};
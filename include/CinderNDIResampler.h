@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+class CinderNDIResampler;
+using CinderNDIResamplerPtr = std::unique_ptr<CinderNDIResampler>;
+
+// Polyphase windowed-sinc sample rate converter for planar float audio.
+// Coefficients are tabulated per fractional phase and interpolated linearly in between, so any ratio is supported
+// and the ratio can be changed between calls without glitches. The inner dot product uses SSE or NEON when available.
+// Channels keep separate history but share the ratio, feed every channel the same number of frames per call.
+class CinderNDIResampler {
+public:
+	enum Quality {
+		FAST, // 8 taps, for monitoring.
+		MEDIUM, // 16 taps.
+		BEST // 32 taps, for program audio.
+	};
+	CinderNDIResampler( size_t numChannels, Quality quality );
+	// Rebuilds the filter if the ratio changed. Input rate is the rate of the frames passed to process().
+	void setRates( double inputRate, double outputRate );
+	// Scales the ratio by ( 1 + correction ) without rebuilding the filter. Meant for corrections of a few hundred ppm.
+	void setRatioCorrection( double correction );
+	double getRatioCorrection() const { return mCorrection; }
+	double getInputRate() const { return mInputRate; }
+	double getOutputRate() const { return mOutputRate; }
+	size_t getNumChannels() const { return mChannels.size(); }
+	Quality getQuality() const { return mQuality; }
+	// Upper bound of the frames process() produces for numInputFrames.
+	size_t getMaxOutputFrames( size_t numInputFrames ) const;
+	// Consumes all input frames and returns the number of frames written to output, which must hold getMaxOutputFrames().
+	size_t process( size_t channel, const float* input, size_t numInputFrames, float* output );
+	// Drops the history of all channels, e.g. after a discontinuity.
+	void reset();
+private:
+	struct Channel {
+		std::vector<float>	mHistory; // Input frames still needed by upcoming output frames.
+		size_t				mNumFrames{ 0 };
+		double				mTime{ 0.0 }; // Position of the next output frame, in input frames relative to mHistory.
+	};
+	void buildFilter();
+private:
+	Quality					mQuality;
+	size_t					mNumTaps;
+	size_t					mNumPhases;
+	float					mRolloff;
+	float					mKaiserBeta;
+	double					mInputRate{ 0.0 };
+	double					mOutputRate{ 0.0 };
+	double					mCorrection{ 0.0 };
+	double					mStep{ 1.0 }; // Input frames advanced per output frame.
+	std::vector<float>		mCoefficients; // mNumPhases + 1 rows of mNumTaps coefficients.
+	std::vector<Channel>	mChannels;
+};
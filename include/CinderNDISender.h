@@ -2,9 +2,23 @@
 
 #include <memory>
 #include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "cinder/gl/Texture.h"
 #include "cinder/audio/SamplePlayerNode.h"
 #include "Processing.NDI.Lib.h"
+#include "CinderNDIUYVYEncoder.h"
+#include "CinderNDILatencyHistogram.h"
+#include "CinderNDISurfacePool.h"
+#include "CinderNDIPboReader.h"
+#include "CinderNDIDownscale.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/app/AppBase.h"
 
 using NDISenderPtr = NDIlib_send_instance_t;
 using NDIVideoFrame = NDIlib_video_frame_v2_t;
@@ -23,12 +37,65 @@ using CinderNDISenderPtr = std::unique_ptr<CinderNDISender>;
 
 class CinderNDISender{
 	public:
+		enum VideoFormat {
+			SURFACE, // Surfaces are sent as they are and converted to YUV by the SDK on the sending thread.
+			UYVY, // Surfaces are converted to UYVY by the library on a worker thread.
+			UYVA // Same, keeping the alpha channel. Surfaces without alpha are sent as UYVY.
+		};
+		enum QueuePolicy {
+			DROP_OLDEST, // A full queue makes room by dropping its oldest frame.
+			BLOCK // A full queue blocks the caller until the sender thread catches up.
+		};
 		struct Description {
 			std::string 	mName; // Name of the sender.
 			std::string 	mGroups; // Comma separated list of the groups the sender belongs to.
 			bool 			mClockVideo{ false }; // Match video-rate to current submission frame rate.
 			bool			mClockAudio{ false }; // Same for audio.
 			std::string		mMetadata;
+			VideoFormat		mVideoFormat{ SURFACE };
+			CinderNDIUYVYEncoder::Kernel		mEncoderKernel{ CinderNDIUYVYEncoder::KERNEL_AUTO };
+			CinderNDIYUVDecoder::ColorSpace		mColorSpace{ CinderNDIYUVDecoder::AUTO };
+			// Queue frames for sender threads that do the connection checks, conversions and SDK calls, so clocked
+			// sends pace those threads instead of the caller. Video and audio are sent from threads of their own, each
+			// clocked stream only waits on itself. sendSurface() and sendAudio() then return right away.
+			bool			mThreaded{ false };
+			QueuePolicy		mQueuePolicy{ DROP_OLDEST };
+			size_t			mVideoQueueSize{ 2 };
+			size_t			mAudioQueueSize{ 8 };
+			size_t			mReadbackRingSize{ 3 }; // Pixel-pack buffers in flight for sendTexture().
+			uint32_t		mConnectionPollInterval{ 100 }; // Milliseconds between refreshes of hasConnections().
+			// Lowers the quality while connected receivers have the sender neither on program nor on preview. Off air only
+			// every mOffAirFrameInterval-th frame is sent, halved in size mOffAirDownscale times. Tally changes are picked up
+			// as they happen, so full quality returns with the first frame after going on air.
+			bool			mAdaptToTally{ false };
+			int				mOffAirFrameInterval{ 2 };
+			int				mOffAirDownscale{ 1 };
+		};
+		// Snapshot returned by getStats().
+		struct Stats {
+			uint64_t							mNumFramesConverted{ 0 };
+			uint64_t							mNumPlanarFramesCopied{ 0 }; // Planar frames that could not be sent in place.
+			uint64_t							mNumSurfacesAllocated{ 0 }; // Surfaces the pool behind acquireSurface() had to create.
+			uint64_t							mNumVideoFramesDropped{ 0 }; // Dropped by a full queue with QueuePolicy::DROP_OLDEST.
+			uint64_t							mNumAudioFramesDropped{ 0 };
+			uint64_t							mNumOffAirFramesSkipped{ 0 }; // Skipped by mAdaptToTally.
+			size_t								mVideoQueueDepth{ 0 };
+			size_t								mAudioQueueDepth{ 0 };
+			CinderNDILatencyHistogram::Summary	mConversion; // Converting one surface to UYVY / UYVA on the worker thread.
+			CinderNDILatencyHistogram::Summary	mVideoQueueResidence; // Time between a frame being queued and picked up for sending.
+			// Duration of the SDK send calls, including the pacing of clocked senders.
+			CinderNDILatencyHistogram::Summary	mVideoSend;
+			CinderNDILatencyHistogram::Summary	mAudioSend;
+			// Per frame readbacks of sendTexture(), waiting on the GPU and mapping, then flipping and swizzling the pixels.
+			CinderNDILatencyHistogram::Summary	mReadbackStall;
+			CinderNDILatencyHistogram::Summary	mReadbackCopy;
+			CinderNDILatencyHistogram::Summary	mOffAirDownscale; // Downscaling one surface while off air.
+		};
+		// Whether any connected receiver shows the sender on program or preview.
+		struct Tally {
+			bool	mOnProgram{ false };
+			bool	mOnPreview{ false };
+			bool	isOnAir() const { return mOnProgram || mOnPreview; }
 		};
 		enum FrameType {
 			PROGRESSIVE,
@@ -44,17 +111,105 @@ class CinderNDISender{
 			std::string mMetadata;
 			
 		};
+		enum PlanarFormat {
+			NV12, // Y plane followed by one plane of interleaved U V samples.
+			I420, // Y, U and V planes.
+			YV12 // Y, V and U planes.
+		};
+		// 4:2:0 frame as produced by hardware decoders, width and height must be even.
+		// Planes and strides are listed in the order the format stores them, NV12 only uses the first two.
+		struct PlanarFrame {
+			PlanarFormat	mFormat{ NV12 };
+			int				mWidth{ 0 };
+			int				mHeight{ 0 };
+			const uint8_t*	mPlanes[3]{ nullptr, nullptr, nullptr };
+			int				mStrides[3]{ 0, 0, 0 };
+		};
 		struct AudioFrameParams {
 			int			mSampleRate{ DEFAULT_AUDIO_SAMPLE_RATE };
 			int64_t		mTimecode{ NDIlib_send_timecode_synthesize };
 		};
 		CinderNDISender( const Description dscr );
 		~CinderNDISender();
+		// As with any asynchronous NDI send the surface must stay untouched until the next call. With VideoFormat::UYVY / UYVA
+		// the call only hands the surface to the worker thread, waiting for the previous conversion to finish first.
+		// Surfaces with an odd width are always sent as they are. Threaded senders copy the surface into a pooled one first,
+		// pass an acquireSurface() one to avoid the copy.
 		void sendSurface( ci::Surface* surface, const VideoFrameParams* videoFrameParams = nullptr );
+		// Returns a surface with cache line aligned rows from the sender's pool. Once handed to sendSurface() the sender keeps
+		// it until the SDK is done with it and then recycles it, so the next frame can be filled right away without copies.
+		// Surfaces dropped without being sent return to the pool as well.
+		ci::Surface8uRef acquireSurface( int width, int height, ci::SurfaceChannelOrder channelOrder = ci::SurfaceChannelOrder::RGBA );
+		// Keeps a reference to the surface for as long as it is in use, the caller may drop or reuse its own right away.
+		void sendSurface( const ci::Surface8uRef& surface, const VideoFrameParams* videoFrameParams = nullptr );
+		// Reads the texture back through a ring of pixel-pack buffers and sends it as BGRA, or UYVY / UYVA, once the GPU is done
+		// with it. Frames therefore go out up to mReadbackRingSize - 1 calls later, the GPU is only waited on when every
+		// buffer is in flight. Must be called on the thread owning the texture's GL context and the sender destroyed there.
+		void sendTexture( const ci::gl::TextureRef& texture, const VideoFrameParams* videoFrameParams = nullptr );
+		void sendTexture( const ci::gl::FboRef& fbo, const VideoFrameParams* videoFrameParams = nullptr );
+		// Sends a planar frame without going through RGBA. NDI takes the planes of a frame as one contiguous block, chroma right
+		// after the luma rows with half the stride for I420 / YV12. Frames already laid out like that are sent in place and
+		// must stay untouched until the next send, others are first copied into a buffer owned by the sender.
+		// Always sent from the calling thread, once the sender thread has sent everything queued before.
+		void sendFrame( const PlanarFrame& frame, const VideoFrameParams* videoFrameParams = nullptr );
+		// Threaded senders copy the buffer into the queue.
 		void sendAudio( ci::audio::Buffer* audioBuffer, const AudioFrameParams* audioFrameParams = nullptr );
 		float getFps() { return mFps; }
+		// Cached by a background thread, cheap enough to check before rendering or packing anything for the sender.
+		// Frames are dropped without being read back, converted or queued while nobody is connected.
+		bool hasConnections() const { return mNumConnections > 0; }
+		int getNumConnections() const { return mNumConnections; }
+		// Emitted from the app's update loop with the new number of connected receivers.
+		ci::signals::Signal<void( int )>& getSignalConnectionsChanged();
+		// Cached by the same background thread as the connections.
+		Tally getTally() const;
+		// True while mAdaptToTally sends off air frames at the lower frame rate and resolution.
+		bool isReducingQuality() const;
+		// Emitted from the app's update loop with the new tally, with mAdaptToTally the quality switches along with it.
+		ci::signals::Signal<void( const Tally& )>& getSignalTallyChanged();
+		Stats getStats() const;
+		void resetStats();
 	private:
+		// Owned copy of a frame handed to the SDK, kept alive until the next send releases it.
+		struct ConvertedFrame {
+			std::vector<uint8_t>	mData;
+			VideoFrameParams		mParams;
+		};
+		struct VideoJob {
+			ci::Surface*							mSurface{ nullptr };
+			ci::Surface8uRef						mSurfaceRef; // Keeps mSurface alive if set.
+			VideoFrameParams						mParams;
+			std::chrono::steady_clock::time_point	mQueueTime;
+		};
+		struct AudioJob {
+			ci::audio::BufferDynamic	mBuffer;
+			AudioFrameParams	mParams;
+		};
+		using AudioJobPtr = std::unique_ptr<AudioJob>;
+		void					sendSurface( ci::Surface* surface, const VideoFrameParams* videoFrameParams, ci::Surface8uRef keepAlive );
+		// Sends asynchronously and holds on to the surface backing the frame, if any, until the next send releases it.
+		void					sendVideoAsync( const NDIVideoFrame& videoFrame, const ci::Surface8uRef& surface );
+		// Same, sending a copy of the metadata that is kept alive along with the frame.
+		void					sendVideoAsync( NDIVideoFrame videoFrame, const ci::Surface8uRef& surface, const std::string& metadata );
+		// Polls for connections and logs metadata sent by receivers, returns false if nobody is listening.
+		bool					checkConnections();
+		ci::Surface8uRef		copySurface( const ci::Surface& surface );
+		// Counts frames while off air and returns true for the ones mOffAirFrameInterval leaves out.
+		bool					skipOffAirFrame();
+		// Returns nullptr if mOffAirDownscale leaves the surface as it is.
+		ci::Surface8uRef		downscaleOffAir( const ci::Surface& surface );
+		void					queueVideoJob( VideoJob&& job );
+		void					sendThread();
+		void					audioSendThread();
+		void					connectionThread();
+		void					update();
+		void					sendVideoJob( VideoJob& job );
+		void					sendAudioFrame( ci::audio::Buffer* audioBuffer, const AudioFrameParams* audioFrameParams );
+		// Sends every finished readback, or waits for the oldest one and sends only that.
+		void					sendCompletedReadbacks( bool wait );
+		ConvertedFrame&			nextConvertedFrame();
 		NDIlib_FourCC_type_e	getNDIColorFormatFromSurface( ci::SurfaceChannelOrder colorFormat );
+		NDIlib_FourCC_type_e	getNDIFourCC( PlanarFormat format );
 		NDIFrameType			getNDIFrameType( FrameType frameType );
 		NDIVideoFrame 			createVideoFrameFromSurface( ci::Surface* surface, const VideoFrameParams* videoFrameParams = nullptr );
 		NDIAudioFrame			createAudioFrameFromBuffer( ci::audio::Buffer* audioBuffer, const AudioFrameParams* audioFrameParams );
@@ -62,4 +217,47 @@ class CinderNDISender{
 		NDISenderPtr			mNDISender{ nullptr };
 		Description				mSenderDescription;
 		float					mFps{ DEFAULT_FPS };
+		std::unique_ptr<CinderNDIUYVYEncoder>	mEncoder;
+		// Sender thread, also runs when not threaded to convert surfaces to UYVY / UYVA.
+		std::unique_ptr<std::thread>			mSendThread;
+		std::unique_ptr<std::thread>			mAudioSendThread;
+		mutable std::mutex						mQueueMutex;
+		std::condition_variable					mQueueCondition;
+		std::deque<VideoJob>					mVideoJobs;
+		std::deque<AudioJobPtr>					mAudioJobs;
+		std::vector<AudioJobPtr>				mFreeAudioJobs;
+		bool									mVideoJobBusy{ false };
+		bool									mSendThreadExiting{ false };
+		// Held from taking a converted frame until it has been handed to the SDK, so the two buffers alternate in send order.
+		std::mutex								mConvertedFrameMutex;
+		ConvertedFrame							mConvertedFrames[2];
+		size_t									mNextConvertedFrame{ 0 };
+		CinderNDISurfacePoolRef					mSurfacePool;
+		std::unique_ptr<std::thread>			mConnectionThread;
+		std::atomic<bool>						mConnectionThreadExiting{ false };
+		std::atomic<int>						mNumConnections{ 0 };
+		int										mNumConnectionsEmitted{ 0 };
+		ci::signals::Connection					mAppConnectionUpdate;
+		ci::signals::Signal<void( int )>		mConnectionsChanged;
+		std::atomic<bool>						mOnProgram{ false };
+		std::atomic<bool>						mOnPreview{ false };
+		Tally									mTallyEmitted;
+		ci::signals::Signal<void( const Tally& )>	mTallyChanged;
+		uint64_t								mOffAirFrameIndex{ 0 };
+		CinderNDIPboReaderPtr					mPboReader;
+		std::deque<VideoFrameParams>			mReadbackParams;
+		std::mutex								mSendMutex;
+		ci::Surface8uRef						mSurfaceInFlight;
+		std::string								mMetadataInFlight[2];
+		size_t									mNextMetadataInFlight{ 0 };
+		std::atomic<uint64_t>					mNumFramesConverted{ 0 };
+		std::atomic<uint64_t>					mNumPlanarFramesCopied{ 0 };
+		std::atomic<uint64_t>					mNumVideoFramesDropped{ 0 };
+		std::atomic<uint64_t>					mNumAudioFramesDropped{ 0 };
+		std::atomic<uint64_t>					mNumOffAirFramesSkipped{ 0 };
+		CinderNDILatencyHistogram				mConversionHistogram;
+		CinderNDILatencyHistogram				mVideoQueueResidenceHistogram;
+		CinderNDILatencyHistogram				mVideoSendHistogram;
+		CinderNDILatencyHistogram				mAudioSendHistogram;
+		CinderNDILatencyHistogram				mDownscaleHistogram;
 };
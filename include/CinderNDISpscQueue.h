@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <utility>
+
+// Bounded wait-free queue for exactly one producer thread and one consumer thread.
+// Popping swaps the slot with the caller's value instead of moving out of it, so types holding heap storage
+// ( e.g. std::string ) keep cycling the same buffers between both sides and stop allocating once warmed up.
+template<typename T>
+class CinderNDISpscQueue {
+public:
+	CinderNDISpscQueue( size_t capacity )
+	: mSlots( capacity + 1 )
+	{
+	}
+	// Producer side. Returns a slot to fill, or nullptr if the queue is full. The value becomes visible with commitPush().
+	T* beginPush()
+	{
+		const size_t tail = mTail.load( std::memory_order_relaxed );
+		if( next( tail ) == mHead.load( std::memory_order_acquire ) ) {
+			return nullptr;
+		}
+		return &mSlots[tail];
+	}
+	void commitPush()
+	{
+		mTail.store( next( mTail.load( std::memory_order_relaxed ) ), std::memory_order_release );
+	}
+	// Consumer side. Returns false if the queue is empty.
+	bool tryPop( T* value )
+	{
+		const size_t head = mHead.load( std::memory_order_relaxed );
+		if( head == mTail.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+		std::swap( *value, mSlots[head] );
+		mHead.store( next( head ), std::memory_order_release );
+		return true;
+	}
+	// Approximate while the other side is active.
+	size_t getSize() const
+	{
+		const size_t head = mHead.load( std::memory_order_acquire );
+		const size_t tail = mTail.load( std::memory_order_acquire );
+		return tail >= head ? tail - head : tail + mSlots.size() - head;
+	}
+	size_t getCapacity() const { return mSlots.size() - 1; }
+private:
+	size_t next( size_t index ) const { return index + 1 == mSlots.size() ? 0 : index + 1; }
+private:
+	std::vector<T>			mSlots; // One slot always stays empty to tell a full queue from an empty one.
+	std::atomic<size_t>		mHead{ 0 };
+	std::atomic<size_t>		mTail{ 0 };
+};
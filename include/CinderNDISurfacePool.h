@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include "cinder/Surface.h"
+
+class CinderNDISurfacePool;
+using CinderNDISurfacePoolRef = std::shared_ptr<CinderNDISurfacePool>;
+
+// CPU counterpart of CinderNDITexturePool, recycles 4 bytes per pixel surfaces keyed by ( width, height, channel order ).
+// Surfaces return to the pool when the last Surface8uRef to them is dropped and never touch GL.
+// With a row alignment the data and every row start on a multiple of it, otherwise surfaces use Cinder's default layout.
+class CinderNDISurfacePool : public std::enable_shared_from_this<CinderNDISurfacePool> {
+public:
+	struct Key {
+		int		mWidth{ 0 };
+		int		mHeight{ 0 };
+		int		mChannelOrder{ ci::SurfaceChannelOrder::RGBA };
+		bool operator<( const Key& other ) const;
+		bool operator==( const Key& other ) const;
+		bool operator!=( const Key& other ) const { return ! ( *this == other ); }
+	};
+	static CinderNDISurfacePoolRef create( size_t rowAlignment = 0 );
+	ci::Surface8uRef acquire( int width, int height, ci::SurfaceChannelOrder channelOrder = ci::SurfaceChannelOrder::RGBA );
+	// Drops every idle surface that does not match the key.
+	void trim( const Key& keep );
+
+	uint64_t getNumHits() const { return mNumHits; }
+	uint64_t getNumMisses() const { return mNumMisses; }
+	size_t getNumIdle() const;
+private:
+	CinderNDISurfacePool( size_t rowAlignment );
+	ci::Surface8uRef allocate( int width, int height, ci::SurfaceChannelOrder channelOrder ) const;
+	void recycle( const Key& key, const ci::Surface8uRef& surface );
+private:
+	size_t											mRowAlignment;
+	mutable std::mutex								mMutex;
+	std::map<Key, std::vector<ci::Surface8uRef>>	mIdleSurfaces;
+	Key												mActiveKey;
+	std::atomic<uint64_t>							mNumHits{ 0 };
+	std::atomic<uint64_t>							mNumMisses{ 0 };
+};
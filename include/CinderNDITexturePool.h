@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Sync.h"
+
+class CinderNDITexturePool;
+using CinderNDITexturePoolRef = std::shared_ptr<CinderNDITexturePool>;
+
+// Recycles textures keyed by ( width, height, internal format ).
+// Textures handed out by acquire() find their way back into the pool once the last TextureRef to them is dropped.
+// A fence is placed on release so the next upload into the texture waits for draws still in flight on the GPU, threads
+// without a GL context defer the release to the app's thread. Only textures matching the most recently requested key
+// are kept, so a resolution change lets the stale ones go as they come back instead of waiting on them.
+class CinderNDITexturePool : public std::enable_shared_from_this<CinderNDITexturePool> {
+public:
+	struct Key {
+		int		mWidth{ 0 };
+		int		mHeight{ 0 };
+		GLint	mInternalFormat{ GL_RGBA8 };
+		bool operator<( const Key& other ) const;
+		bool operator==( const Key& other ) const;
+		bool operator!=( const Key& other ) const { return ! ( *this == other ); }
+	};
+	static CinderNDITexturePoolRef create();
+	// Returns a pooled texture for the key or allocates a new one. Must be called with a GL context current, reused
+	// textures make that context wait on the GPU until the commands issued before their release have completed.
+	ci::gl::TextureRef acquire( int width, int height, GLint internalFormat = GL_RGBA8 );
+	// Drops every idle texture that does not match the key.
+	void trim( const Key& keep );
+
+	uint64_t getNumHits() const { return mNumHits; }
+	uint64_t getNumMisses() const { return mNumMisses; }
+	size_t getNumIdle() const;
+private:
+	CinderNDITexturePool() = default;
+	struct Idle {
+		ci::gl::TextureRef	mTexture;
+		ci::gl::SyncRef		mFence; // Signaled once the GPU is done with what was issued before the release.
+	};
+	// Expects the releasing thread to have a GL context current.
+	void recycle( const Key& key, const ci::gl::TextureRef& tex );
+private:
+	mutable std::mutex								mMutex;
+	std::map<Key, std::deque<Idle>>					mIdleTextures;
+	Key												mActiveKey;
+	std::atomic<uint64_t>							mNumHits{ 0 };
+	std::atomic<uint64_t>							mNumMisses{ 0 };
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include "cinder/Surface.h"
+#include "CinderNDIVideoFormat.h"
+
+// Converts 8 bit RGB( A ) pixels into UYVY, NDI's native format, and optionally the alpha plane of UYVA.
+// Output is video range with the same coefficients CinderNDIYUVDecoder decodes with, chroma is the average of each
+// pixel pair. All kernels produce output bit exact to the scalar one. Stateless, encode() may be called from any thread.
+class CinderNDIUYVYEncoder {
+public:
+	enum Kernel {
+		KERNEL_AUTO, // Fastest kernel the CPU supports.
+		KERNEL_SCALAR,
+		KERNEL_SSE2,
+		KERNEL_AVX2,
+		KERNEL_NEON
+	};
+	// Unsupported kernels fall back to KERNEL_AUTO.
+	CinderNDIUYVYEncoder( CinderNDIYUVDecoder::ColorSpace colorSpace = CinderNDIYUVDecoder::AUTO, Kernel kernel = KERNEL_AUTO );
+	// Width must be even. Every row of dst receives width * 2 bytes of UYVY. If alpha is not null every row of it receives
+	// width bytes of alpha, UYVA frames keep this plane right after the last UYVY row. Surfaces without alpha write 255.
+	void encode( const ci::Surface8u& surface, uint8_t* dst, int dstRowBytes, uint8_t* alpha = nullptr, int alphaRowBytes = 0 ) const;
+	void encode( const uint8_t* src, int srcRowBytes, const ci::SurfaceChannelOrder& channelOrder, int width, int height,
+				 uint8_t* dst, int dstRowBytes, uint8_t* alpha = nullptr, int alphaRowBytes = 0 ) const;
+	Kernel getKernel() const { return mKernel; }
+	CinderNDIYUVDecoder::ColorSpace getColorSpace() const { return mColorSpace; }
+	static bool isKernelSupported( Kernel kernel );
+	static const char* getKernelName( Kernel kernel );
+private:
+	CinderNDIYUVDecoder::ColorSpace		mColorSpace;
+	Kernel								mKernel;
+};
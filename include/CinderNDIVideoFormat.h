@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/Surface.h"
+#include "Processing.NDI.Lib.h"
+
+// Describes how a received NDI frame maps onto a texture with 4 bytes per texel.
+// RGBA / BGRA frames map 1:1. UYVY frames are uploaded as half-width RGBA8 textures where each texel holds
+// one U Y0 V Y1 macropixel. UYVA frames add the alpha plane below the UYVY rows, two alpha rows per texel row,
+// so the whole frame still goes up in a single upload.
+struct CinderNDITextureLayout {
+	int		mWidth{ 0 };
+	int		mHeight{ 0 };
+	GLenum	mDataFormat{ GL_RGBA };
+	GLint	mInternalFormat{ GL_RGBA8 };
+};
+
+// Returns false for FourCCs that cannot be uploaded as is, and for UYVA frames with an odd height.
+bool getNDITextureLayout( const NDIlib_video_frame_v2_t& videoFrame, CinderNDITextureLayout* layout );
+bool isNDIFourCCYUV( NDIlib_FourCC_type_e fourCC );
+// Channel order of a surface holding the frame with the same layout. YUV frames report RGBA.
+ci::SurfaceChannelOrder getNDISurfaceChannelOrder( NDIlib_FourCC_type_e fourCC );
+
+class CinderNDIYUVDecoder;
+using CinderNDIYUVDecoderPtr = std::unique_ptr<CinderNDIYUVDecoder>;
+
+// Draws textures received as UYVY / UYVA, converting them to RGB( A ) in the fragment shader.
+// RGB( A ) textures are drawn through the stock shader so callers can draw any received texture through it.
+class CinderNDIYUVDecoder {
+public:
+	enum ColorSpace {
+		AUTO, // BT.601 for SD resolutions ( below 720 lines ), BT.709 otherwise.
+		BT601,
+		BT709
+	};
+	CinderNDIYUVDecoder( ColorSpace colorSpace = AUTO );
+	// frameSize is the resolution of the NDI frame, not of the texture.
+	void draw( const ci::gl::TextureRef& tex, NDIlib_FourCC_type_e fourCC, const ci::ivec2& frameSize, const ci::Rectf& dstRect );
+	const ci::gl::GlslProgRef& getGlsl() const { return mGlsl; }
+	// Sets the uniforms getGlsl() expects for a frame, for use with custom geometry.
+	void setUniforms( NDIlib_FourCC_type_e fourCC, const ci::ivec2& frameSize );
+private:
+	ColorSpace				mColorSpace;
+	ci::gl::GlslProgRef		mGlsl;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "cinder/Cinder.h"
+#include "Processing.NDI.Lib.h"
+
+class CinderNDIVideoFrame;
+using NDIVideoFrameRef = std::shared_ptr<CinderNDIVideoFrame>;
+
+class CinderNDIVideoFrameTracker;
+using CinderNDIVideoFrameTrackerRef = std::shared_ptr<CinderNDIVideoFrameTracker>;
+
+using NDIReceiverInstanceRef = std::shared_ptr<void>;
+
+// A video frame captured by an NDI receiver, read in place from the SDK buffer.
+// The buffer is handed back with NDIlib_recv_free_video_v2 once the last reference goes away,
+// which keeps the receiver instance alive until then even if the CinderNDIReceiver is gone.
+class CinderNDIVideoFrame {
+public:
+	~CinderNDIVideoFrame();
+	CinderNDIVideoFrame( const CinderNDIVideoFrame& ) = delete;
+	CinderNDIVideoFrame& operator=( const CinderNDIVideoFrame& ) = delete;
+
+	const uint8_t*					getData() const { return mVideoFrame.p_data; }
+	int								getRowBytes() const { return mVideoFrame.line_stride_in_bytes; }
+	int								getWidth() const { return mVideoFrame.xres; }
+	int								getHeight() const { return mVideoFrame.yres; }
+	ci::ivec2						getSize() const { return ci::ivec2( mVideoFrame.xres, mVideoFrame.yres ); }
+	NDIlib_FourCC_type_e			getFourCC() const { return mVideoFrame.FourCC; }
+	int								getFrameRateNumerator() const { return mVideoFrame.frame_rate_N; }
+	int								getFrameRateDenominator() const { return mVideoFrame.frame_rate_D; }
+	float							getPictureAspectRatio() const { return mVideoFrame.picture_aspect_ratio; }
+	NDIlib_frame_format_type_e		getFrameFormatType() const { return mVideoFrame.frame_format_type; }
+	int64_t							getTimecode() const { return mVideoFrame.timecode; } // 100ns units.
+	int64_t							getTimestamp() const { return mVideoFrame.timestamp; } // 100ns units, NDIlib_recv_timestamp_undefined if unknown.
+	const char*						getMetadata() const { return mVideoFrame.p_metadata; } // Can be nullptr.
+	const NDIlib_video_frame_v2_t&	getNDIVideoFrame() const { return mVideoFrame; }
+private:
+	friend class CinderNDIVideoFrameTracker;
+	CinderNDIVideoFrame( const CinderNDIVideoFrameTrackerRef& tracker, const NDIlib_video_frame_v2_t& videoFrame );
+private:
+	CinderNDIVideoFrameTrackerRef	mTracker;
+	NDIlib_video_frame_v2_t			mVideoFrame;
+};
+
+// Shared between a receiver and the frames it handed out. Owns a reference to the SDK receiver instance
+// and caps the number of frames held outside the SDK so a slow consumer cannot exhaust its buffers.
+class CinderNDIVideoFrameTracker : public std::enable_shared_from_this<CinderNDIVideoFrameTracker> {
+public:
+	CinderNDIVideoFrameTracker( const NDIReceiverInstanceRef& receiverInstance, size_t maxFramesInFlight );
+	// Blocks until another frame may be captured, the timeout expires or cancel() is called.
+	bool waitForCapacity( uint32_t timeoutInMs );
+	// Takes ownership of a frame returned by NDIlib_recv_capture_v2.
+	NDIVideoFrameRef adopt( const NDIlib_video_frame_v2_t& videoFrame );
+	void cancel();
+
+	size_t getNumFramesInFlight() const { return mNumFramesInFlight; }
+	size_t getMaxFramesInFlight() const { return mMaxFramesInFlight; }
+private:
+	friend class CinderNDIVideoFrame;
+	void release( const NDIlib_video_frame_v2_t& videoFrame );
+private:
+	NDIReceiverInstanceRef		mReceiverInstance;
+	const size_t				mMaxFramesInFlight;
+	std::atomic<size_t>			mNumFramesInFlight{ 0 };
+	std::mutex					mMutex;
+	std::condition_variable		mCapacityCond;
+	bool						mCanceled{ false };
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "cinder/gl/Texture.h"
+#include "cinder/Surface.h"
+#include "CinderNDIVideoFrame.h"
+#include "CinderNDILatencyHistogram.h"
+
+// A received video frame on its way from the receive thread to getVideoTexture() / getVideoSurface() / getVideoFrame().
+struct CinderNDIVideoQueueEntry {
+	ci::gl::TextureRef		mTexture;
+	ci::Surface8uRef		mSurface;
+	NDIVideoFrameRef		mFrame;
+	NDIlib_FourCC_type_e	mFourCC{ NDIlib_FourCC_type_RGBA };
+	ci::ivec2				mSize; // Resolution of the NDI frame, UYVY textures are half as wide.
+	int64_t					mTimecode{ 0 };
+	std::string				mMetadata; // Copy of the frame's metadata, left empty when mFrame keeps it alive.
+};
+
+class CinderNDIVideoQueue;
+using CinderNDIVideoQueuePtr = std::unique_ptr<CinderNDIVideoQueue>;
+
+// Hands received frames from the receive thread to the consumer. The receive thread never blocks on it,
+// frames that the policy has no room for are dropped and counted instead.
+class CinderNDIVideoQueue {
+public:
+	enum Policy {
+		MAILBOX, // Only the newest frame is kept, lowest latency.
+		FIFO, // Frames are consumed in order, the oldest is dropped once mDepth frames are queued.
+		MAX_AGE // Like FIFO, but frames queued for longer than mMaxAge are skipped.
+	};
+	struct Format {
+		Policy	mPolicy{ FIFO };
+		size_t	mDepth{ 5 };
+		float	mMaxAge{ 100.0f }; // In milliseconds.
+	};
+	CinderNDIVideoQueue( const Format& format );
+	void push( const CinderNDIVideoQueueEntry& entry );
+	// Returns false if there is no new frame for the consumer.
+	bool pop( CinderNDIVideoQueueEntry* entry );
+	void clear();
+
+	size_t getDepth() const;
+	uint64_t getNumDropped() const { return mNumDropped; }
+	// Time frames spent queued before being popped by the consumer.
+	CinderNDILatencyHistogram& getResidenceHistogram() { return mResidence; }
+	const CinderNDILatencyHistogram& getResidenceHistogram() const { return mResidence; }
+private:
+	using Clock = std::chrono::steady_clock;
+	struct Item {
+		CinderNDIVideoQueueEntry	mEntry;
+		Clock::time_point			mQueuedTime;
+	};
+private:
+	const Format					mFormat;
+	mutable std::mutex				mMutex;
+	std::deque<Item>				mItems;
+	std::atomic<uint64_t>			mNumDropped{ 0 };
+	CinderNDILatencyHistogram		mResidence;
+};
@@ -11,6 +11,23 @@ if( NOT TARGET Cinder-NDI )
 	add_library( Cinder-NDI "${CINDER_NDI_SOURCE_PATH}/CinderNDIReceiver.cpp"
 							"${CINDER_NDI_SOURCE_PATH}/CinderNDISender.cpp"
 							"${CINDER_NDI_SOURCE_PATH}/CinderNDIFinder.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIPboUploader.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDITexturePool.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDISurfacePool.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIVideoFormat.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIVideoFrame.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIVideoQueue.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIReceiverPool.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDILatencyHistogram.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIResampler.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDILatencyController.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIInputNode.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIMetadata.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIUYVYEncoder.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIPboReader.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIDownscale.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIAudioPacketizer.cpp"
+							"${CINDER_NDI_SOURCE_PATH}/CinderNDIOutputNode.cpp"
 	)
 
 	target_include_directories( Cinder-NDI PUBLIC "${CINDER_NDI_INCLUDE_PATH}" "${NDI_INCLUDE_PATH}" )
@@ -3,7 +3,7 @@
 #include "cinder/gl/gl.h"
 #include "CinderNDIReceiver.h"
 #include "CinderNDIFinder.h"
-#include "cinder/audio/Voice.h"
+#include "CinderNDIInputNode.h"
 #include "cinder/audio/Context.h"
 
 using namespace ci;
@@ -18,13 +18,13 @@ public:
 private:
 	void sourceAdded( const NDISource& source );
 	void sourceRemoved( const std::string sourceName );
-	void audioOut( ci::audio::Buffer* audioOutBuffer, size_t sampleRate );
 private:
 	CinderNDIFinderPtr mCinderNDIFinder;
 	CinderNDIReceiverPtr mCinderNDIReceiver;
 	ci::signals::Connection mNDISourceAdded;
 	ci::signals::Connection mNDISourceRemoved;
-	ci::audio::VoiceRef	mNDIVoice;
+	CinderNDIInputNodeRef mNDIInputNode;
+	CinderNDIYUVDecoderPtr mYUVDecoder;
 };
 
 void prepareSettings( BasicReceiverApp::Settings* settings )
@@ -37,6 +37,11 @@ void BasicReceiverApp::cleanup()
 		mNDISourceAdded.disconnect();	
 		mNDISourceRemoved.disconnect();
 	}
+	// The node reads from the receiver on the audio thread, stop it before the receiver goes away.
+	if( mNDIInputNode ) {
+		mNDIInputNode->disable();
+		mNDIInputNode->disconnectAll();
+	}
 }
 
 void BasicReceiverApp::sourceAdded( const NDISource& source )
@@ -47,6 +52,12 @@ void BasicReceiverApp::sourceAdded( const NDISource& source )
 		CinderNDIReceiver::Description recvDscr;
 		recvDscr.source = &source;
 		mCinderNDIReceiver = std::make_unique<CinderNDIReceiver>( recvDscr );
+		// Received audio goes straight into the graph, resampled and mapped onto the output channels by the node.
+		auto ctx = ci::audio::master();
+		mNDIInputNode = ctx->makeNode( new CinderNDIInputNode( mCinderNDIReceiver.get() ) );
+		mNDIInputNode >> ctx->getOutput();
+		mNDIInputNode->enable();
+		ctx->enable();
 	}
 	else
 		mCinderNDIReceiver->connect( source );
@@ -59,15 +70,7 @@ void BasicReceiverApp::sourceRemoved( std::string sourceName )
 
 void BasicReceiverApp::setup()
 {
-	mNDIVoice = ci::audio::Voice::create( [ this ] ( ci::audio::Buffer* buffer, size_t sampleRate ) {			
-		if( mCinderNDIReceiver ) {
-			auto audioBuffer = mCinderNDIReceiver->getAudioBuffer();
-			if( audioBuffer && ! audioBuffer->isEmpty() ) {
-				buffer->copy( *audioBuffer.get() );
-			}
-		}
-	}, ci::audio::Voice::Options().channels( 2 ));
-	mNDIVoice->start();
+	mYUVDecoder = std::make_unique<CinderNDIYUVDecoder>();
 	// Create the NDI finder
 	CinderNDIFinder::Description finderDscr;
 	mCinderNDIFinder = std::make_unique<CinderNDIFinder>( finderDscr );
@@ -90,8 +93,10 @@ void BasicReceiverApp::draw()
 	gl::clear( ColorA::black() );
 	auto videoTex = mCinderNDIReceiver != nullptr ? mCinderNDIReceiver->getVideoTexture() : nullptr;
 	if( videoTex ) {
-		Rectf centeredRect = Rectf( videoTex->getBounds() ).getCenteredFit( getWindowBounds(), true );
-		gl::draw( videoTex, centeredRect );
+		auto videoSize = mCinderNDIReceiver->getVideoSize();
+		Rectf centeredRect = Rectf( 0, 0, videoSize.x, videoSize.y ).getCenteredFit( getWindowBounds(), true );
+		// Draws UYVY frames through the decoding shader and anything else as is.
+		mYUVDecoder->draw( videoTex, mCinderNDIReceiver->getVideoFourCC(), videoSize, centeredRect );
 	}
 }
 
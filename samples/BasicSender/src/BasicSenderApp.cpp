@@ -2,14 +2,15 @@
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
 #include "cinder/gl/Texture.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/Log.h"
 #include "CinderNDISender.h"
+#include "CinderNDIOutputNode.h"
 #include "cinder/qtime/QuickTimeGl.h"
-#include "AsyncSurfaceReader.h"
 #include "cinder/audio/audio.h"
 using namespace ci;
 using namespace ci::app;
 
-using AsyncSurfaceReaderPtr = std::unique_ptr<AsyncSurfaceReader>;
 class BasicSenderApp : public App {
   public:
 	  BasicSenderApp() {}
@@ -20,20 +21,18 @@ class BasicSenderApp : public App {
 	void keyDown( KeyEvent event ) final;
 	void fileDrop( FileDropEvent event ) final;
 	void resize() final;
+	void cleanup() override;
 
   private:
 	void loadMovieFile( const fs::path &moviePath );
   private:
 	qtime::MovieGlRef		mMovie;
-	gl::TextureRef			mFrameTexture;
-	ci::SurfaceRef 			mSurface;
-	AsyncSurfaceReaderPtr 	mAsyncSurfaceReader;
+	gl::FboRef				mFbo;
 	CinderNDISenderPtr		mCinderNDISender;
 	audio::BufferPlayerNodeRef		mBufferPlayerNode;
 	audio::GainNodeRef				mGain;
 	audio::SourceFileRef 			mAudioSourceFile;
-	audio::Buffer					mAudioFrame;
-	uint32_t						mAudioFrameOffset;
+	CinderNDIOutputNodeRef			mNDIOutput;
 };
 
 void prepareSettings( BasicSenderApp::Settings* settings )
@@ -53,8 +52,6 @@ void BasicSenderApp::loadMovieFile( const fs::path &moviePath )
 		console() << "Exception caught trying to load the movie from path: " << moviePath << ", what: " << exc.what() << std::endl;
 		mMovie.reset();
 	}
-
-	mFrameTexture.reset();
 }
 
 void BasicSenderApp::setup()
@@ -67,80 +64,74 @@ void BasicSenderApp::setup()
 	// add a Gain to reduce the volume
 	mGain = ctx->makeNode( new audio::GainNode( 0.0f ) );
 
-	// connect and enable the Context
-	mBufferPlayerNode >> mGain >> ctx->getOutput();
-	ctx->enable();
-
 	fs::path moviePath = getOpenFilePath();
 	if( ! moviePath.empty() ) {
 		loadMovieFile( moviePath );
 	}
 
-	mAsyncSurfaceReader = std::make_unique<AsyncSurfaceReader>( getWindowWidth(), getWindowHeight() );
+	mFbo = gl::Fbo::create( getWindowWidth(), getWindowHeight() );
 	CinderNDISender::Description senderDscr;
 	senderDscr.mName = "Cinder_NDI_Sender";
 	senderDscr.mClockVideo = true;
 	senderDscr.mClockAudio = true;
+	// Clocked sends pace the sender thread instead of update().
+	senderDscr.mThreaded = true;
 	mCinderNDISender = std::make_unique<CinderNDISender>( senderDscr );
+	mCinderNDISender->getSignalConnectionsChanged().connect( [] ( int numConnections ) {
+		CI_LOG_I( "Receivers connected: " << numConnections );
+	} );
+	mCinderNDISender->getSignalTallyChanged().connect( [] ( const CinderNDISender::Tally& tally ) {
+		CI_LOG_I( "On program: " << tally.mOnProgram << ", on preview: " << tally.mOnPreview );
+	} );
+
+	// Audio is sent from the audio graph, ahead of the gain so muting the local output does not mute the NDI one.
+	mNDIOutput = ctx->makeNode( new CinderNDIOutputNode( mCinderNDISender.get() ) );
+	// connect and enable the Context
+	mBufferPlayerNode >> mNDIOutput >> mGain >> ctx->getOutput();
+	ctx->enable();
+}
+
+void BasicSenderApp::cleanup()
+{
+	// The node's sender thread has to stop before the sender goes away.
+	mNDIOutput->disable();
+	mNDIOutput->uninitialize();
+	mNDIOutput->disconnectAll();
+	mNDIOutput.reset();
+	mCinderNDISender.reset();
 }
 
 void BasicSenderApp::resize()
 {
-	mAsyncSurfaceReader.reset( new AsyncSurfaceReader( getWindowWidth(), getWindowHeight() ) );
+	mFbo = gl::Fbo::create( getWindowWidth(), getWindowHeight() );
 }
 
 void BasicSenderApp::update()
 {
 	getWindow()->setTitle( "CinderNDI-Sender - " + std::to_string( (int) getAverageFps() ) + " FPS" );
-	// Send the audio
-	if( mBufferPlayerNode && mAudioSourceFile && mBufferPlayerNode->isEnabled() ) {
-		int samplesPerFrame = ci::audio::Context::master()->getSampleRate() / mCinderNDISender->getFps();
-		int totalFrameNum = mBufferPlayerNode->getNumFrames();
-		if( mAudioFrameOffset < totalFrameNum ) {
-			int distToEof = totalFrameNum - mAudioFrameOffset;
-			if( distToEof < samplesPerFrame )
-				samplesPerFrame = distToEof;
-			CinderNDISender::AudioFrameParams audioParams;
-			audioParams.mSampleRate = ci::audio::Context::master()->getSampleRate();
-			mAudioFrame = audio::Buffer( samplesPerFrame, mBufferPlayerNode->getNumChannels() );
-			// Copy one frame of audio containing samplesPerFrame and send it to the network.
-			mAudioFrame.copyOffset( *mBufferPlayerNode->getBuffer().get(), samplesPerFrame, 0, mAudioFrameOffset );
-			mCinderNDISender->sendAudio( &mAudioFrame, &audioParams );
-			// Advance our audio frame for the next round.
-			mAudioFrameOffset += samplesPerFrame;
-		}
-	}
 	// Send the video
 	{
-		mAsyncSurfaceReader->bind();
-		gl::ScopedViewport sVp( 0, 0, mAsyncSurfaceReader->getWidth(), mAsyncSurfaceReader->getHeight() );
+		gl::ScopedFramebuffer scopedFbo( mFbo );
+		gl::ScopedViewport sVp( 0, 0, mFbo->getWidth(), mFbo->getHeight() );
+		gl::ScopedMatrices scopedMatrices;
+		gl::setMatricesWindow( mFbo->getSize() );
 		gl::clear( ColorA::black() );
 		if( mMovie && mMovie->getTexture() ) {
-			Rectf centeredRect = Rectf( mMovie->getTexture()->getBounds() ).getCenteredFit( getWindowBounds(), true );
+			Rectf centeredRect = Rectf( mMovie->getTexture()->getBounds() ).getCenteredFit( mFbo->getBounds(), true );
 			gl::draw( mMovie->getTexture(), centeredRect );
 		}
-		mAsyncSurfaceReader->unbind();
 	}
-	mSurface = mAsyncSurfaceReader->readPixels();
-	mCinderNDISender->sendSurface( mSurface.get() );
-	// Create our preview texture
-	if( mSurface ) {
-		if( ! mFrameTexture || ( mFrameTexture->getSize() != mSurface->getSize() ) ) {
-			mFrameTexture = ci::gl::Texture::create( *mSurface );
-		}
-	}
-
+	// Read back asynchronously, the sender takes care of flipping the bottom up framebuffer and skips
+	// the readback while no receiver is connected.
+	mCinderNDISender->sendTexture( mFbo );
 }
 
 void BasicSenderApp::draw()
 {
 	gl::clear( ColorA::black() );
 	// Preview our NDI output.
-	if( mSurface ) {
-		mFrameTexture->update( *mSurface );
-		Rectf centeredRect = Rectf( mFrameTexture->getBounds() ).getCenteredFit( getWindowBounds(), true );
-		gl::draw( mFrameTexture, centeredRect );
-	}
+	Rectf centeredRect = Rectf( mFbo->getBounds() ).getCenteredFit( getWindowBounds(), true );
+	gl::draw( mFbo->getColorTexture(), centeredRect );
 	/*
 	if( mMovie ) {
 		Rectf centeredRect = Rectf( mMovie->getTexture()->getBounds() ).getCenteredFit( getWindowBounds(), true );
@@ -156,7 +147,6 @@ void BasicSenderApp::fileDrop( FileDropEvent event )
 	mBufferPlayerNode->loadBuffer( mAudioSourceFile );
 	mBufferPlayerNode->enable();
 	mBufferPlayerNode->seek( 0.0f );
-	mAudioFrameOffset = 0;
 }
 
 void BasicSenderApp::keyDown( KeyEvent event )
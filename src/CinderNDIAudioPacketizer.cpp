@@ -0,0 +1,102 @@
+#include "CinderNDIAudioPacketizer.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// NDI timecodes count in 100 ns units.
+const int64_t TIMECODE_UNITS_PER_SECOND = 10000000;
+
+} // anonymous namespace
+
+CinderNDIAudioPacketizer::CinderNDIAudioPacketizer( const Description& dscr )
+: mDescription( dscr )
+{
+	mDescription.mNumChannels = std::max<size_t>( mDescription.mNumChannels, 1 );
+	mDescription.mFrameRateNumerator = std::max( mDescription.mFrameRateNumerator, 1 );
+	mDescription.mFrameRateDenomenator = std::max( mDescription.mFrameRateDenomenator, 1 );
+	// Frames differ by at most one sample, the larger size bounds all of them.
+	const size_t maxFrameSize = static_cast<size_t>( getSamplePosition( 1 ) ) + 1;
+	reserve( maxFrameSize * std::max<size_t>( mDescription.mMaxBufferedFrames, 1 ) );
+	mFrame.setSize( maxFrameSize, mDescription.mNumChannels );
+}
+
+void CinderNDIAudioPacketizer::write( const ci::audio::Buffer& buffer, size_t numFrames, size_t offset )
+{
+	if( offset >= buffer.getNumFrames() ) {
+		return;
+	}
+	numFrames = std::min( numFrames, buffer.getNumFrames() - offset );
+	reserve( mNumBuffered + numFrames );
+	for( size_t ch = 0; ch < mDescription.mNumChannels; ++ch ) {
+		float* dst = mBuffered.getChannel( ch ) + mNumBuffered;
+		if( ch < buffer.getNumChannels() ) {
+			std::memcpy( dst, buffer.getChannel( ch ) + offset, numFrames * sizeof( float ) );
+		}
+		else {
+			std::fill( dst, dst + numFrames, 0.0f );
+		}
+	}
+	mNumBuffered += numFrames;
+}
+
+ci::audio::Buffer* CinderNDIAudioPacketizer::pop( CinderNDISender::AudioFrameParams* params )
+{
+	const size_t frameSize = getNextFrameSize();
+	if( mNumBuffered < frameSize ) {
+		return nullptr;
+	}
+	if( params ) {
+		params->mSampleRate = mDescription.mSampleRate;
+		params->mTimecode = getNextTimecode();
+	}
+	// Shrinking stays within the allocation made up front.
+	mFrame.setSize( frameSize, mDescription.mNumChannels );
+	const size_t remaining = mNumBuffered - frameSize;
+	for( size_t ch = 0; ch < mDescription.mNumChannels; ++ch ) {
+		float* buffered = mBuffered.getChannel( ch );
+		std::memcpy( mFrame.getChannel( ch ), buffered, frameSize * sizeof( float ) );
+		// Rarely more than a frame is left, moving it is cheaper than bookkeeping a ring.
+		std::memmove( buffered, buffered + frameSize, remaining * sizeof( float ) );
+	}
+	mNumBuffered = remaining;
+	++mFrameIndex;
+	return &mFrame;
+}
+
+size_t CinderNDIAudioPacketizer::getNextFrameSize() const
+{
+	return static_cast<size_t>( getSamplePosition( mFrameIndex + 1 ) - getSamplePosition( mFrameIndex ) );
+}
+
+int64_t CinderNDIAudioPacketizer::getNextTimecode() const
+{
+	return mDescription.mStartTimecode + static_cast<int64_t>( mFrameIndex ) * TIMECODE_UNITS_PER_SECOND * mDescription.mFrameRateDenomenator / mDescription.mFrameRateNumerator;
+}
+
+void CinderNDIAudioPacketizer::reset()
+{
+	mNumBuffered = 0;
+	mFrameIndex = 0;
+}
+
+int64_t CinderNDIAudioPacketizer::getSamplePosition( uint64_t frameIndex ) const
+{
+	// Rounding the absolute position down instead of each frame's size is what produces the cadence without any drift.
+	return static_cast<int64_t>( frameIndex ) * mDescription.mSampleRate * mDescription.mFrameRateDenomenator / mDescription.mFrameRateNumerator;
+}
+
+void CinderNDIAudioPacketizer::reserve( size_t numFrames )
+{
+	if( numFrames <= mCapacity ) {
+		return;
+	}
+	// Channels are laid out by capacity, growing means moving every buffered channel to its new offset.
+	const size_t capacity = std::max( numFrames, mCapacity * 2 );
+	ci::audio::BufferDynamic grown( capacity, mDescription.mNumChannels );
+	for( size_t ch = 0; ch < mDescription.mNumChannels && mNumBuffered > 0; ++ch ) {
+		std::memcpy( grown.getChannel( ch ), mBuffered.getChannel( ch ), mNumBuffered * sizeof( float ) );
+	}
+	mBuffered = grown;
+	mCapacity = capacity;
+}
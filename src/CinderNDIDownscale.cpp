@@ -0,0 +1,73 @@
+#include "CinderNDIDownscale.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#include <emmintrin.h>
+	#define CINDER_NDI_DOWNSCALE_SSE2
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#include <arm_neon.h>
+	#define CINDER_NDI_DOWNSCALE_NEON
+#endif
+
+namespace {
+
+inline uint8_t average( uint8_t a, uint8_t b )
+{
+	return static_cast<uint8_t>( ( a + b + 1 ) >> 1 );
+}
+
+// Averages vertically first and then horizontally, rounding up at each step like the SIMD averages do,
+// so every path produces the same output.
+void downscaleRowScalar( const uint8_t* row0, const uint8_t* row1, int pixelInc, int begin, int end, uint8_t* dst )
+{
+	for( int x = begin; x < end; ++x ) {
+		const uint8_t* a = row0 + x * 2 * pixelInc;
+		const uint8_t* b = row1 + x * 2 * pixelInc;
+		for( int c = 0; c < pixelInc; ++c ) {
+			dst[x * pixelInc + c] = average( average( a[c], b[c] ), average( a[c + pixelInc], b[c + pixelInc] ) );
+		}
+	}
+}
+
+// Converts 4 output pixels per iteration and returns how many it converted.
+int downscaleRowSIMD( const uint8_t* row0, const uint8_t* row1, int width, uint8_t* dst )
+{
+	int x = 0;
+#if defined( CINDER_NDI_DOWNSCALE_SSE2 )
+	for( ; x + 4 <= width; x += 4 ) {
+		const __m128i* a = reinterpret_cast<const __m128i*>( row0 + x * 8 );
+		const __m128i* b = reinterpret_cast<const __m128i*>( row1 + x * 8 );
+		const __m128 v0 = _mm_castsi128_ps( _mm_avg_epu8( _mm_loadu_si128( a ), _mm_loadu_si128( b ) ) );
+		const __m128 v1 = _mm_castsi128_ps( _mm_avg_epu8( _mm_loadu_si128( a + 1 ), _mm_loadu_si128( b + 1 ) ) );
+		const __m128i even = _mm_castps_si128( _mm_shuffle_ps( v0, v1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+		const __m128i odd = _mm_castps_si128( _mm_shuffle_ps( v0, v1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x * 4 ), _mm_avg_epu8( even, odd ) );
+	}
+#elif defined( CINDER_NDI_DOWNSCALE_NEON )
+	for( ; x + 4 <= width; x += 4 ) {
+		const uint8x16_t v0 = vrhaddq_u8( vld1q_u8( row0 + x * 8 ), vld1q_u8( row1 + x * 8 ) );
+		const uint8x16_t v1 = vrhaddq_u8( vld1q_u8( row0 + x * 8 + 16 ), vld1q_u8( row1 + x * 8 + 16 ) );
+		const uint32x4x2_t pixels = vuzpq_u32( vreinterpretq_u32_u8( v0 ), vreinterpretq_u32_u8( v1 ) );
+		vst1q_u8( dst + x * 4, vrhaddq_u8( vreinterpretq_u8_u32( pixels.val[0] ), vreinterpretq_u8_u32( pixels.val[1] ) ) );
+	}
+#endif
+	return x;
+}
+
+} // anonymous namespace
+
+void downscaleNDISurfaceByHalf( const ci::Surface8u& src, ci::Surface8u* dst )
+{
+	if( ! dst ) {
+		return;
+	}
+	const int width = src.getWidth() / 2;
+	const int height = src.getHeight() / 2;
+	const int pixelInc = src.getPixelInc();
+	for( int y = 0; y < height; ++y ) {
+		const uint8_t* row0 = src.getData() + ( y * 2 ) * src.getRowBytes();
+		const uint8_t* row1 = row0 + src.getRowBytes();
+		uint8_t* dstRow = dst->getData() + y * dst->getRowBytes();
+		const int converted = pixelInc == 4 ? downscaleRowSIMD( row0, row1, width, dstRow ) : 0;
+		downscaleRowScalar( row0, row1, pixelInc, converted, width, dstRow );
+	}
+}
@@ -0,0 +1,13 @@
+#include "CinderNDIInputNode.h"
+#include "CinderNDIReceiver.h"
+
+CinderNDIInputNode::CinderNDIInputNode( CinderNDIReceiver* receiver, const Format& format )
+: ci::audio::InputNode( format ), mReceiver( receiver )
+{
+}
+
+void CinderNDIInputNode::process( ci::audio::Buffer* buffer )
+{
+	// Underruns leave silence in the buffer and are counted by the receiver.
+	mReceiver->readAudio( buffer );
+}
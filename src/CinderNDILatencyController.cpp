@@ -0,0 +1,37 @@
+#include "CinderNDILatencyController.h"
+#include <algorithm>
+
+CinderNDILatencyController::CinderNDILatencyController( const Format& format )
+: mFormat( format )
+{
+}
+
+size_t CinderNDILatencyController::getTargetFrames( double sampleRate, size_t minFrames ) const
+{
+	return std::max( size_t( mFormat.mTargetLatency * sampleRate / 1000.0 ), minFrames );
+}
+
+void CinderNDILatencyController::update( size_t fillFrames, size_t numFrames, size_t targetFrames, double sampleRate )
+{
+	// The fill is measured right after a write, half a frame above its average between writes.
+	const double fill = std::max( double( fillFrames ) - numFrames * 0.5, 0.0 );
+	const double dt = numFrames / sampleRate;
+	if( mSmoothedFill < 0.0 ) {
+		mSmoothedFill = fill;
+	}
+	else {
+		mSmoothedFill += ( fill - mSmoothedFill ) * dt / ( mFormat.mSmoothing + dt );
+	}
+	mLatency = float( mSmoothedFill / sampleRate * 1000.0 );
+
+	const double error = ( mSmoothedFill - double( targetFrames ) ) / sampleRate;
+	const double maxCorrection = mFormat.mMaxCorrection * 1.0e-6;
+	mIntegral = std::min( std::max( mIntegral + error * dt / ( mFormat.mResponseTime * mFormat.mDriftTime ), -maxCorrection ), maxCorrection );
+	mCorrection = std::min( std::max( error / mFormat.mResponseTime + mIntegral, -maxCorrection ), maxCorrection );
+}
+
+void CinderNDILatencyController::reset( size_t targetFrames )
+{
+	// Keep the drift estimate, the clocks have not changed.
+	mSmoothedFill = double( targetFrames );
+}
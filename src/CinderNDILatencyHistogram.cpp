@@ -0,0 +1,82 @@
+#include "CinderNDILatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+CinderNDILatencyHistogram::CinderNDILatencyHistogram()
+{
+	reset();
+}
+
+size_t CinderNDILatencyHistogram::getBucket( uint32_t microseconds )
+{
+	// Values below 4 get a bucket each, every power of two above is split into 4 buckets.
+	if( microseconds < 4 ) {
+		return microseconds;
+	}
+	size_t exponent = 2;
+	while( ( microseconds >> ( exponent + 1 ) ) != 0 ) {
+		++exponent;
+	}
+	const size_t subBucket = ( microseconds >> ( exponent - 2 ) ) & 3;
+	return std::min( ( exponent - 1 ) * 4 + subBucket, NUM_BUCKETS - 1 );
+}
+
+float CinderNDILatencyHistogram::getBucketCenter( size_t bucket )
+{
+	if( bucket < 4 ) {
+		return bucket + 0.5f;
+	}
+	const size_t exponent = bucket / 4 + 1;
+	const float width = float( 1u << ( exponent - 2 ) );
+	return ( 4 + bucket % 4 ) * width + width * 0.5f;
+}
+
+void CinderNDILatencyHistogram::record( float milliseconds )
+{
+	const uint32_t microseconds = uint32_t( std::min( std::max( milliseconds * 1000.0f, 0.0f ), 4.0e9f ) );
+	mBuckets[getBucket( microseconds )].fetch_add( 1, std::memory_order_relaxed );
+	uint32_t current = mMaxMicroseconds.load( std::memory_order_relaxed );
+	while( microseconds > current && ! mMaxMicroseconds.compare_exchange_weak( current, microseconds, std::memory_order_relaxed ) ) {}
+}
+
+CinderNDILatencyHistogram::Summary CinderNDILatencyHistogram::getSummary() const
+{
+	// Buckets are read one by one without stopping writers, the snapshot can be off by the samples recorded meanwhile.
+	std::array<uint64_t, NUM_BUCKETS> counts;
+	Summary summary;
+	for( size_t i = 0; i < NUM_BUCKETS; ++i ) {
+		counts[i] = mBuckets[i].load( std::memory_order_relaxed );
+		summary.mCount += counts[i];
+	}
+	summary.mMax = mMaxMicroseconds.load( std::memory_order_relaxed ) / 1000.0f;
+	if( summary.mCount == 0 ) {
+		return summary;
+	}
+	const uint64_t p50Rank = uint64_t( std::ceil( summary.mCount * 0.5 ) );
+	const uint64_t p99Rank = uint64_t( std::ceil( summary.mCount * 0.99 ) );
+	uint64_t seen = 0;
+	for( size_t i = 0; i < NUM_BUCKETS; ++i ) {
+		const bool belowP50 = seen < p50Rank;
+		const bool belowP99 = seen < p99Rank;
+		seen += counts[i];
+		if( belowP50 && seen >= p50Rank ) {
+			summary.mP50 = getBucketCenter( i ) / 1000.0f;
+		}
+		if( belowP99 && seen >= p99Rank ) {
+			summary.mP99 = getBucketCenter( i ) / 1000.0f;
+			break;
+		}
+	}
+	// Bucket centers can overshoot the largest sample recorded.
+	summary.mP50 = std::min( summary.mP50, summary.mMax );
+	summary.mP99 = std::min( summary.mP99, summary.mMax );
+	return summary;
+}
+
+void CinderNDILatencyHistogram::reset()
+{
+	for( auto& bucket : mBuckets ) {
+		bucket.store( 0, std::memory_order_relaxed );
+	}
+	mMaxMicroseconds.store( 0, std::memory_order_relaxed );
+}
@@ -0,0 +1,300 @@
+#include "CinderNDIMetadata.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+struct Entity {
+	const char*	mName;
+	const char*	mReplacement;
+};
+const Entity PREDEFINED_ENTITIES[] = { { "amp", "&" }, { "lt", "<" }, { "gt", ">" }, { "quot", "\"" }, { "apos", "'" } };
+
+bool isSpace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isNameEnd( char c )
+{
+	return isSpace( c ) || c == '=' || c == '/' || c == '>';
+}
+
+// Appends the UTF8 encoding of a code point, returns its length.
+size_t encodeUtf8( uint32_t codePoint, char* out )
+{
+	if( codePoint < 0x80 ) {
+		out[0] = char( codePoint );
+		return 1;
+	}
+	if( codePoint < 0x800 ) {
+		out[0] = char( 0xC0 | ( codePoint >> 6 ) );
+		out[1] = char( 0x80 | ( codePoint & 0x3F ) );
+		return 2;
+	}
+	if( codePoint < 0x10000 ) {
+		out[0] = char( 0xE0 | ( codePoint >> 12 ) );
+		out[1] = char( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+		out[2] = char( 0x80 | ( codePoint & 0x3F ) );
+		return 3;
+	}
+	out[0] = char( 0xF0 | ( codePoint >> 18 ) );
+	out[1] = char( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) );
+	out[2] = char( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+	out[3] = char( 0x80 | ( codePoint & 0x3F ) );
+	return 4;
+}
+
+} // anonymous namespace
+
+bool CinderNDIXmlString::operator==( const char* str ) const
+{
+	return std::strncmp( mData, str, mSize ) == 0 && str[mSize] == '\0';
+}
+
+bool CinderNDIXmlString::toInt( int64_t* value ) const
+{
+	size_t i = 0;
+	bool negative = false;
+	if( i < mSize && ( mData[i] == '-' || mData[i] == '+' ) ) {
+		negative = mData[i] == '-';
+		++i;
+	}
+	if( i == mSize ) {
+		return false;
+	}
+	int64_t result = 0;
+	for( ; i < mSize; ++i ) {
+		if( mData[i] < '0' || mData[i] > '9' ) {
+			return false;
+		}
+		result = result * 10 + ( mData[i] - '0' );
+	}
+	*value = negative ? -result : result;
+	return true;
+}
+
+bool CinderNDIXmlString::toDouble( double* value ) const
+{
+	// strtod needs a terminated string, numbers longer than this are not worth supporting.
+	char buffer[64];
+	if( mSize == 0 || mSize >= sizeof( buffer ) ) {
+		return false;
+	}
+	std::memcpy( buffer, mData, mSize );
+	buffer[mSize] = '\0';
+	char* end = nullptr;
+	*value = std::strtod( buffer, &end );
+	return end == buffer + mSize;
+}
+
+size_t CinderNDIXmlString::decode( char* out, size_t capacity ) const
+{
+	size_t length = 0;
+	char encoded[4];
+	for( size_t i = 0; i < mSize; ) {
+		const char* piece = mData + i;
+		size_t pieceSize = 1;
+		size_t consumed = 1;
+		if( mData[i] == '&' ) {
+			const void* semicolon = std::memchr( mData + i, ';', mSize - i );
+			if( semicolon ) {
+				const CinderNDIXmlString entity = { mData + i + 1, size_t( (const char*)semicolon - mData - i - 1 ) };
+				const char* replacement = nullptr;
+				for( const auto& predefined : PREDEFINED_ENTITIES ) {
+					if( entity == predefined.mName ) {
+						replacement = predefined.mReplacement;
+						break;
+					}
+				}
+				if( replacement ) {
+					piece = replacement;
+				}
+				else if( entity.mSize > 1 && entity.mData[0] == '#' ) {
+					const bool hex = entity.mData[1] == 'x' || entity.mData[1] == 'X';
+					char* end = nullptr;
+					char digits[16] = {};
+					const size_t numDigits = entity.mSize - ( hex ? 2 : 1 );
+					if( numDigits > 0 && numDigits < sizeof( digits ) ) {
+						std::memcpy( digits, entity.mData + ( hex ? 2 : 1 ), numDigits );
+						const unsigned long codePoint = std::strtoul( digits, &end, hex ? 16 : 10 );
+						if( end == digits + numDigits && codePoint <= 0x10FFFF ) {
+							pieceSize = encodeUtf8( uint32_t( codePoint ), encoded );
+							piece = encoded;
+						}
+					}
+				}
+				if( piece != mData + i ) {
+					consumed = entity.mSize + 2;
+				}
+			}
+		}
+		if( length + pieceSize < capacity ) {
+			std::memcpy( out + length, piece, pieceSize );
+		}
+		length += pieceSize;
+		i += consumed;
+	}
+	if( capacity > 0 ) {
+		out[std::min( length, capacity - 1 )] = '\0';
+	}
+	return length;
+}
+
+CinderNDIXmlReader::CinderNDIXmlReader( const char* data, size_t size )
+: mCursor( data ), mEnd( data + size )
+{
+}
+
+void CinderNDIXmlReader::fail()
+{
+	mError = true;
+	mInTag = false;
+	mCursor = mEnd;
+}
+
+void CinderNDIXmlReader::closeTag( bool empty )
+{
+	mInTag = false;
+	mEmptyElement = empty;
+	if( ! empty ) {
+		++mOpenElements;
+	}
+}
+
+bool CinderNDIXmlReader::skipPast( const char* terminator )
+{
+	const size_t length = std::strlen( terminator );
+	while( mCursor + length <= mEnd ) {
+		const char* found = (const char*)std::memchr( mCursor, terminator[0], mEnd - mCursor );
+		if( ! found || found + length > mEnd ) {
+			break;
+		}
+		if( std::memcmp( found, terminator, length ) == 0 ) {
+			mCursor = found + length;
+			return true;
+		}
+		mCursor = found + 1;
+	}
+	fail();
+	return false;
+}
+
+bool CinderNDIXmlReader::nextElement()
+{
+	while( mInTag && nextAttribute() ) {}
+	while( ! mError && mCursor < mEnd ) {
+		const char* open = (const char*)std::memchr( mCursor, '<', mEnd - mCursor );
+		if( ! open ) {
+			mCursor = mEnd;
+			return false;
+		}
+		mCursor = open + 1;
+		const size_t remaining = mEnd - mCursor;
+		if( remaining >= 3 && std::memcmp( mCursor, "!--", 3 ) == 0 ) {
+			skipPast( "-->" );
+			continue;
+		}
+		if( remaining >= 8 && std::memcmp( mCursor, "![CDATA[", 8 ) == 0 ) {
+			skipPast( "]]>" );
+			continue;
+		}
+		if( remaining > 0 && ( *mCursor == '?' || *mCursor == '!' ) ) {
+			skipPast( ">" );
+			continue;
+		}
+		if( remaining > 0 && *mCursor == '/' ) {
+			if( mOpenElements > 0 ) {
+				--mOpenElements;
+			}
+			skipPast( ">" );
+			continue;
+		}
+		const char* name = mCursor;
+		while( mCursor < mEnd && ! isNameEnd( *mCursor ) ) {
+			++mCursor;
+		}
+		if( mCursor == name || mCursor == mEnd ) {
+			fail();
+			return false;
+		}
+		mElementName = { name, size_t( mCursor - name ) };
+		mAttributeName = {};
+		mAttributeValue = {};
+		mDepth = mOpenElements;
+		mInTag = true;
+		mEmptyElement = false;
+		return true;
+	}
+	return false;
+}
+
+bool CinderNDIXmlReader::nextAttribute()
+{
+	if( ! mInTag ) {
+		return false;
+	}
+	while( mCursor < mEnd && isSpace( *mCursor ) ) {
+		++mCursor;
+	}
+	if( mCursor == mEnd ) {
+		fail();
+		return false;
+	}
+	if( *mCursor == '>' ) {
+		++mCursor;
+		closeTag( false );
+		return false;
+	}
+	if( *mCursor == '/' ) {
+		if( mCursor + 1 == mEnd || mCursor[1] != '>' ) {
+			fail();
+			return false;
+		}
+		mCursor += 2;
+		closeTag( true );
+		return false;
+	}
+	const char* name = mCursor;
+	while( mCursor < mEnd && ! isNameEnd( *mCursor ) ) {
+		++mCursor;
+	}
+	const char* nameEnd = mCursor;
+	while( mCursor < mEnd && isSpace( *mCursor ) ) {
+		++mCursor;
+	}
+	if( nameEnd == name || mCursor == mEnd || *mCursor != '=' ) {
+		fail();
+		return false;
+	}
+	++mCursor;
+	while( mCursor < mEnd && isSpace( *mCursor ) ) {
+		++mCursor;
+	}
+	if( mCursor == mEnd || ( *mCursor != '"' && *mCursor != '\'' ) ) {
+		fail();
+		return false;
+	}
+	const char quote = *mCursor++;
+	const char* closing = (const char*)std::memchr( mCursor, quote, mEnd - mCursor );
+	if( ! closing ) {
+		fail();
+		return false;
+	}
+	mAttributeName = { name, size_t( nameEnd - name ) };
+	mAttributeValue = { mCursor, size_t( closing - mCursor ) };
+	mCursor = closing + 1;
+	return true;
+}
+
+bool CinderNDIXmlReader::findAttribute( const char* name, CinderNDIXmlString* value )
+{
+	while( nextAttribute() ) {
+		if( mAttributeName == name ) {
+			*value = mAttributeValue;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,110 @@
+#include "CinderNDIOutputNode.h"
+#include "CinderNDISender.h"
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+namespace {
+
+// Packets of audio the rings can hold, enough to ride out a send stalling for a few packets.
+const size_t RING_BUFFER_PACKETS = 8;
+
+} // anonymous namespace
+
+CinderNDIOutputNode::CinderNDIOutputNode( CinderNDISender* sender, const Format& format, size_t framesPerPacket )
+: ci::audio::NodeAutoPullable( format ), mSender( sender ), mFramesPerPacketRequested( framesPerPacket )
+{
+}
+
+CinderNDIOutputNode::~CinderNDIOutputNode()
+{
+	stopSendThread();
+}
+
+void CinderNDIOutputNode::initialize()
+{
+	stopSendThread();
+	mSampleRate = getSampleRate();
+	mFramesPerPacket = mFramesPerPacketRequested ? mFramesPerPacketRequested : std::max<size_t>( mSampleRate / 100, 1 );
+	const size_t numChannels = getNumChannels();
+	mRingBuffers.clear();
+	for( size_t ch = 0; ch < numChannels; ++ch ) {
+		mRingBuffers.emplace_back( mFramesPerPacket * RING_BUFFER_PACKETS + getFramesPerBlock() * 2 );
+	}
+	mPacket.setSize( mFramesPerPacket, numChannels );
+	mSendThreadExiting = false;
+	mSendThread = std::make_unique<std::thread>( std::bind( &CinderNDIOutputNode::sendThread, this ) );
+}
+
+void CinderNDIOutputNode::uninitialize()
+{
+	stopSendThread();
+}
+
+void CinderNDIOutputNode::stopSendThread()
+{
+	if( mSendThread ) {
+		{
+			std::lock_guard<std::mutex> lock( mSendMutex );
+			mSendThreadExiting = true;
+		}
+		mSendCondition.notify_all();
+		mSendThread->join();
+		mSendThread.reset();
+	}
+}
+
+void CinderNDIOutputNode::process( ci::audio::Buffer* buffer )
+{
+	const size_t numFrames = buffer->getNumFrames();
+	const size_t numChannels = std::min( buffer->getNumChannels(), mRingBuffers.size() );
+	// Channels are written one after the other, only write the block if every channel has room for it so they stay aligned.
+	for( size_t ch = 0; ch < numChannels; ++ch ) {
+		if( mRingBuffers[ch].getAvailableWrite() < numFrames ) {
+			++mNumOverruns;
+			return;
+		}
+	}
+	for( size_t ch = 0; ch < numChannels; ++ch ) {
+		mRingBuffers[ch].write( buffer->getChannel( ch ), numFrames );
+	}
+	// Notifying does not take the mutex, the audio thread never waits on the sender thread.
+	if( numChannels > 0 && mRingBuffers[numChannels - 1].getAvailableRead() >= mFramesPerPacket ) {
+		mSendCondition.notify_one();
+	}
+}
+
+void CinderNDIOutputNode::sendThread()
+{
+	CinderNDISender::AudioFrameParams params;
+	params.mSampleRate = static_cast<int>( mSampleRate );
+	auto isReady = [this] {
+		bool ready = ! mRingBuffers.empty();
+		for( auto& ring : mRingBuffers ) {
+			ready &= ring.getAvailableRead() >= mFramesPerPacket;
+		}
+		return ready;
+	};
+	// The audio thread notifies without the mutex, so a wakeup can slip in before the wait. Waiting at most a packet
+	// bounds the delay that causes.
+	const auto packetDuration = std::chrono::microseconds( std::max<size_t>( mFramesPerPacket * 1000000 / std::max<size_t>( mSampleRate, 1 ), 1000 ) );
+	while( true ) {
+		{
+			std::unique_lock<std::mutex> lock( mSendMutex );
+			mSendCondition.wait_for( lock, packetDuration, [this, &isReady] { return mSendThreadExiting || isReady(); } );
+		}
+		if( mSendThreadExiting ) {
+			break;
+		}
+		if( ! isReady() ) {
+			continue;
+		}
+		for( size_t ch = 0; ch < mRingBuffers.size(); ++ch ) {
+			mRingBuffers[ch].read( mPacket.getChannel( ch ), mFramesPerPacket );
+		}
+		// Nobody is listening, the packet is only read to keep the rings moving.
+		if( mSender->hasConnections() ) {
+			mSender->sendAudio( &mPacket, &params );
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#include "CinderNDIPboReader.h"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include "cinder/gl/scoped.h"
+#include "cinder/gl/wrapper.h"
+
+namespace {
+
+// Swaps the red and blue bytes of every RGBA pixel, simple enough for compilers to vectorize.
+void copyRowRGBAToBGRA( const uint8_t* src, uint8_t* dst, int width )
+{
+	for( int x = 0; x < width; ++x ) {
+		uint32_t pixel;
+		std::memcpy( &pixel, src + x * 4, 4 );
+		pixel = ( pixel & 0xFF00FF00u ) | ( ( pixel >> 16 ) & 0xFFu ) | ( ( pixel & 0xFFu ) << 16 );
+		std::memcpy( dst + x * 4, &pixel, 4 );
+	}
+}
+
+} // anonymous namespace
+
+CinderNDIPboReader::CinderNDIPboReader( size_t ringSize, const CinderNDISurfacePoolRef& surfacePool )
+: mSlots( std::max<size_t>( ringSize, 2 ) )
+, mSurfacePool( surfacePool )
+{
+}
+
+CinderNDIPboReader::~CinderNDIPboReader()
+{
+	for( auto& slot : mSlots ) {
+		if( slot.mPbo ) {
+			glDeleteBuffers( 1, &slot.mPbo );
+		}
+	}
+	if( mFramebuffer ) {
+		glDeleteFramebuffers( 1, &mFramebuffer );
+	}
+}
+
+bool CinderNDIPboReader::read( const ci::gl::TextureRef& texture )
+{
+	if( ! texture ) {
+		return false;
+	}
+	auto& slot = mSlots[ mNextSlot ];
+	if( slot.mFence ) {
+		return false;
+	}
+	const int width = texture->getWidth();
+	const int height = texture->getHeight();
+	const size_t size = size_t( width ) * height * 4;
+	if( slot.mCapacity < size ) {
+		if( ! slot.mPbo ) {
+			glGenBuffers( 1, &slot.mPbo );
+		}
+		ci::gl::ScopedBuffer scopedPbo( GL_PIXEL_PACK_BUFFER, slot.mPbo );
+		glBufferData( GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ );
+		slot.mCapacity = size;
+	}
+	if( ! mFramebuffer ) {
+		glGenFramebuffers( 1, &mFramebuffer );
+	}
+	{
+		ci::gl::ScopedFramebuffer scopedFbo( GL_READ_FRAMEBUFFER, mFramebuffer );
+		ci::gl::ScopedBuffer scopedPbo( GL_PIXEL_PACK_BUFFER, slot.mPbo );
+		glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->getTarget(), texture->getId(), 0 );
+		glReadBuffer( GL_COLOR_ATTACHMENT0 );
+		glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+		// RGBA is the one readback format every implementation supports, the swizzle happens while copying out.
+		glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->getTarget(), 0, 0 );
+	}
+	slot.mWidth = width;
+	slot.mHeight = height;
+	slot.mFlip = ! texture->isTopDown();
+	slot.mFence = ci::gl::Sync::create();
+	mPending.push_back( mNextSlot );
+	mNextSlot = ( mNextSlot + 1 ) % mSlots.size();
+	return true;
+}
+
+ci::Surface8uRef CinderNDIPboReader::popCompleted( bool wait )
+{
+	if( mPending.empty() ) {
+		return nullptr;
+	}
+	auto& slot = mSlots[ mPending.front() ];
+	auto start = std::chrono::steady_clock::now();
+	// The flush bit makes sure the fence actually gets submitted.
+	auto status = slot.mFence->clientWaitSync( GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+	while( wait && status == GL_TIMEOUT_EXPIRED ) {
+		status = slot.mFence->clientWaitSync( 0, 1000000 );
+	}
+	if( status == GL_TIMEOUT_EXPIRED ) {
+		return nullptr;
+	}
+	mPending.pop_front();
+	slot.mFence.reset();
+	if( status == GL_WAIT_FAILED ) {
+		return nullptr;
+	}
+
+	ci::gl::ScopedBuffer scopedPbo( GL_PIXEL_PACK_BUFFER, slot.mPbo );
+	const size_t rowBytes = size_t( slot.mWidth ) * 4;
+	auto* mappedData = static_cast<const uint8_t*>( glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, rowBytes * slot.mHeight, GL_MAP_READ_BIT ) );
+	if( ! mappedData ) {
+		return nullptr;
+	}
+	auto mapped = std::chrono::steady_clock::now();
+	mStallHistogram.record( mapped - start );
+
+	auto surface = mSurfacePool->acquire( slot.mWidth, slot.mHeight, ci::SurfaceChannelOrder::BGRA );
+	for( int row = 0; row < slot.mHeight; ++row ) {
+		const int srcRow = slot.mFlip ? slot.mHeight - 1 - row : row;
+		copyRowRGBAToBGRA( mappedData + srcRow * rowBytes, surface->getData() + row * surface->getRowBytes(), slot.mWidth );
+	}
+	glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+	mCopyHistogram.record( std::chrono::steady_clock::now() - mapped );
+	return surface;
+}
+
+void CinderNDIPboReader::resetStats()
+{
+	mStallHistogram.reset();
+	mCopyHistogram.reset();
+}
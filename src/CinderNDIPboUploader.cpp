@@ -0,0 +1,113 @@
+#include "CinderNDIPboUploader.h"
+#include <cstring>
+#include "cinder/gl/scoped.h"
+#include "cinder/gl/wrapper.h"
+
+// glBufferStorage is not exposed on macOS ( GL 4.1 ) or GLES.
+#if ! defined( CINDER_GL_ES ) && ! defined( CINDER_MAC )
+	#define CINDER_NDI_PERSISTENT_PBO 1
+#else
+	#define CINDER_NDI_PERSISTENT_PBO 0
+#endif
+
+CinderNDIPboUploader::CinderNDIPboUploader( size_t ringSize, const CinderNDITexturePoolRef& texturePool )
+: mSlots( std::max<size_t>( ringSize, 2 ) )
+, mTexturePool( texturePool )
+{
+#if CINDER_NDI_PERSISTENT_PBO
+	auto version = ci::gl::getVersion();
+	mPersistentMapping = version.first > 4 || ( version.first == 4 && version.second >= 4 ) || ci::gl::isExtensionAvailable( "GL_ARB_buffer_storage" );
+#endif
+}
+
+CinderNDIPboUploader::~CinderNDIPboUploader()
+{
+	for( auto& slot : mSlots ) {
+		release( slot );
+	}
+}
+
+void CinderNDIPboUploader::allocate( Slot& slot, size_t size )
+{
+	release( slot );
+	glGenBuffers( 1, &slot.mPbo );
+	ci::gl::ScopedBuffer scopedPbo( GL_PIXEL_UNPACK_BUFFER, slot.mPbo );
+#if CINDER_NDI_PERSISTENT_PBO
+	if( mPersistentMapping ) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage( GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags );
+		slot.mMappedData = static_cast<uint8_t*>( glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, size, flags ) );
+	}
+	else
+#endif
+	{
+		glBufferData( GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW );
+	}
+	slot.mCapacity = size;
+}
+
+void CinderNDIPboUploader::release( Slot& slot )
+{
+	if( slot.mPbo ) {
+		// Deleting a persistently mapped buffer implicitly unmaps it.
+		glDeleteBuffers( 1, &slot.mPbo );
+	}
+	slot.mPbo = 0;
+	slot.mCapacity = 0;
+	slot.mMappedData = nullptr;
+}
+
+bool CinderNDIPboUploader::upload( const uint8_t* data, const CinderNDITextureLayout& layout, int rowBytes )
+{
+	auto& slot = mSlots[ mNextSlot ];
+	if( slot.mFence ) {
+		return false;
+	}
+	const size_t size = static_cast<size_t>( rowBytes ) * layout.mHeight;
+	if( slot.mCapacity < size ) {
+		allocate( slot, size );
+	}
+	ci::gl::ScopedBuffer scopedPbo( GL_PIXEL_UNPACK_BUFFER, slot.mPbo );
+	if( slot.mMappedData ) {
+		std::memcpy( slot.mMappedData, data, size );
+	}
+	else {
+		// The fence of this slot has already signaled so the GPU is done with it and the mapping needs no synchronization.
+		auto* mappedData = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+		if( ! mappedData ) {
+			return false;
+		}
+		std::memcpy( mappedData, data, size );
+		glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+	}
+	slot.mTexture = mTexturePool->acquire( layout.mWidth, layout.mHeight, layout.mInternalFormat );
+	{
+		ci::gl::ScopedTextureBind scopedTex( slot.mTexture );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+		glPixelStorei( GL_UNPACK_ROW_LENGTH, rowBytes / 4 );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, layout.mWidth, layout.mHeight, layout.mDataFormat, GL_UNSIGNED_BYTE, nullptr );
+		glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+	}
+	slot.mFence = ci::gl::Sync::create();
+	mPending.push_back( mNextSlot );
+	mNextSlot = ( mNextSlot + 1 ) % mSlots.size();
+	return true;
+}
+
+ci::gl::TextureRef CinderNDIPboUploader::popCompleted()
+{
+	if( mPending.empty() ) {
+		return nullptr;
+	}
+	auto& slot = mSlots[ mPending.front() ];
+	// Zero timeout, this only polls the fence. The flush bit makes sure the fence actually gets submitted.
+	auto status = slot.mFence->clientWaitSync( GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+	if( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED ) {
+		return nullptr;
+	}
+	mPending.pop_front();
+	slot.mFence.reset();
+	ci::gl::TextureRef tex;
+	std::swap( tex, slot.mTexture );
+	return tex;
+}
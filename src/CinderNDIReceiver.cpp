@@ -1,11 +1,22 @@
 #include "CinderNDIReceiver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #define CI_MIN_LOG_LEVEL 2
 #include "cinder/Log.h"
 #include "cinder/Surface.h"
 #include "cinder/gl/Sync.h"
+#include "cinder/gl/scoped.h"
 #include "cinder/audio/Context.h"
 
+namespace {
+// Upper bound for a single wait inside the SDK. The threads re-check their state in between,
+// so this is also how long stopping or destroying a receiver can take at most.
+const uint32_t CAPTURE_TIMEOUT_MS = 10;
+} // anonymous namespace
+
 CinderNDIReceiver::CinderNDIReceiver( const Description dscr )
+: mReceiverDescription( dscr ), mLatencyController( dscr.mAudioLatency )
 {
 	if( ! NDIlib_initialize() ) {
 		throw std::runtime_error( "Cannot run NDI on this machine. Probably unsupported CPU." );
@@ -20,46 +31,220 @@ CinderNDIReceiver::CinderNDIReceiver( const Description dscr )
 	if( ! mNDIReceiver ) {
 		throw std::runtime_error( "Cannot create NDI Receiver. NDIlib_recv_create_v3 returned nullptr" );
 	}	
-	mVideoFramesBuffer = std::make_unique<VideoFramesBuffer>( 5 );
-	auto ctx = ci::gl::Context::create( ci::gl::context() );
-	mVideoRecvThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiver::videoRecvThread, this, ctx ) );
-	mAudioRecvThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiver::audioRecvThread, this ) );
+	// Frames handed out with VideoOutput::FRAME share ownership of the instance, it is destroyed with the last of them.
+	mNDIReceiverInstance = NDIReceiverInstanceRef( mNDIReceiver, NDIlib_recv_destroy );
+	// Stays empty without video, but keeps the getVideo* calls valid.
+	mVideoFramesBuffer = std::make_unique<VideoFramesBuffer>( mReceiverDescription.mVideoQueue );
+	mMetadataQueue = std::make_unique<CinderNDIMetadataQueue>( mReceiverDescription.mMetadataQueueSize );
+	mState = mReceiverDescription.mAutoStart ? RUNNING : STOPPED;
+	// Only what the bandwidth needs is created, audio-only and metadata-only receivers never touch GL.
+	if( auto pool = mReceiverDescription.mReceiverPool ) {
+		if( receivesVideo() ) {
+			if( mReceiverDescription.mVideoOutput == SURFACE ) {
+				mSurfacePool = CinderNDISurfacePool::create();
+			}
+			else {
+				// Frames are kept in place until the consumer or the pool's upload thread is done with them.
+				mFrameTracker = std::make_shared<CinderNDIVideoFrameTracker>( mNDIReceiverInstance, mReceiverDescription.mMaxFramesInFlight );
+			}
+			if( mReceiverDescription.mVideoOutput == TEXTURE ) {
+				if( ! mReceiverDescription.mLazyUpload && ! pool->hasUploadContext() ) {
+					throw std::runtime_error( "Cannot create NDI Receiver. The receiver pool was created without an upload context" );
+				}
+				mTexturePool = CinderNDITexturePool::create();
+			}
+			mPoolVideoJob = pool->add( this, CinderNDIReceiverPool::Job::VIDEO );
+		}
+		if( receivesAudio() ) {
+			mPoolAudioJob = pool->add( this, CinderNDIReceiverPool::Job::AUDIO );
+		}
+		else {
+			mPoolMetadataJob = pool->add( this, CinderNDIReceiverPool::Job::METADATA );
+		}
+		// Workers read the job members, only hand the receiver over once they are all assigned.
+		if( isRunning() ) {
+			pool->resume( this );
+		}
+		return;
+	}
+	if( receivesVideo() ) {
+		// Headless receivers never create a GL context.
+		ci::gl::ContextRef ctx;
+		if( mReceiverDescription.mVideoOutput == SURFACE ) {
+			mSurfacePool = CinderNDISurfacePool::create();
+		}
+		else if( mReceiverDescription.mVideoOutput == FRAME ) {
+			mFrameTracker = std::make_shared<CinderNDIVideoFrameTracker>( mNDIReceiverInstance, mReceiverDescription.mMaxFramesInFlight );
+		}
+		else if( mReceiverDescription.mLazyUpload ) {
+			// Uploads happen on the thread calling getVideoTexture(), so no shared context is needed.
+			mFrameTracker = std::make_shared<CinderNDIVideoFrameTracker>( mNDIReceiverInstance, mReceiverDescription.mMaxFramesInFlight );
+			mTexturePool = CinderNDITexturePool::create();
+		}
+		else {
+			mTexturePool = CinderNDITexturePool::create();
+			ctx = ci::gl::Context::create( ci::gl::context() );
+		}
+		mVideoRecvThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiver::videoRecvThread, this, ctx ) );
+	}
+	if( receivesAudio() ) {
+		mAudioRecvThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiver::audioRecvThread, this ) );
+	}
+	else {
+		mMetadataRecvThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiver::metadataRecvThread, this ) );
+	}
 }
 
 CinderNDIReceiver::~CinderNDIReceiver()
 {
 	{
-		mExitVideoThread = true;
-		mVideoFramesBuffer->cancel();
-		mVideoRecvThread->join();
+		std::lock_guard<std::mutex> lock( mStateMutex );
+		mState = EXITING;
 	}
-	{
-		mExitAudioThread = true;
-		mAudioRecvThread->join();
+	mStateCond.notify_all();
+	if( mFrameTracker ) {
+		mFrameTracker->cancel();
 	}
-
-	if( mNDIReceiver ) {
-		NDIlib_recv_destroy( mNDIReceiver );
-		mNDIReceiver = nullptr;
+	if( mReceiverDescription.mReceiverPool ) {
+		mReceiverDescription.mReceiverPool->remove( this );
+	}
+	else {
+		for( auto thread : { mVideoRecvThread.get(), mAudioRecvThread.get(), mMetadataRecvThread.get() } ) {
+			if( thread ) {
+				thread->join();
+			}
+		}
 	}
+
+	mNDIReceiverInstance.reset();
+	mNDIReceiver = nullptr;
 	NDIlib_destroy();
 }
 
 void CinderNDIReceiver::videoRecvThread( ci::gl::ContextRef ctx )
 {
-	ctx->makeCurrent();
-	while( ! mExitVideoThread ) {
-		receiveVideo();
+	if( ctx ) {
+		ctx->makeCurrent();
+	}
+	if( ctx && mReceiverDescription.mUploadMode == PBO_RING ) {
+		mPboUploader = std::make_unique<CinderNDIPboUploader>( mReceiverDescription.mPboRingSize, mTexturePool );
 	}
+	while( waitUntilRunning() ) {
+		receiveVideo( CAPTURE_TIMEOUT_MS );
+	}
+	// Release the buffers while the shared context is still current on this thread.
+	mPboUploader.reset();
 }
 
 void CinderNDIReceiver::audioRecvThread()
 {
-	while( ! mExitAudioThread ) {
-		receiveAudio();
+	while( waitUntilRunning() ) {
+		receiveAudio( CAPTURE_TIMEOUT_MS );
+	}
+}
+
+void CinderNDIReceiver::metadataRecvThread()
+{
+	while( waitUntilRunning() ) {
+		receiveMetadata( CAPTURE_TIMEOUT_MS );
+	}
+}
+
+bool CinderNDIReceiver::waitUntilRunning()
+{
+	if( mState == RUNNING ) {
+		return true;
+	}
+	std::unique_lock<std::mutex> lock( mStateMutex );
+	mStateCond.wait( lock, [ this ] { return mState != STOPPED; } );
+	return mState == RUNNING;
+}
+
+void CinderNDIReceiver::start()
+{
+	{
+		std::lock_guard<std::mutex> lock( mStateMutex );
+		if( mState != STOPPED ) {
+			return;
+		}
+		mState = RUNNING;
+	}
+	mStateCond.notify_all();
+	if( mReceiverDescription.mReceiverPool ) {
+		mReceiverDescription.mReceiverPool->resume( this );
+	}
+}
+
+void CinderNDIReceiver::stop()
+{
+	std::lock_guard<std::mutex> lock( mStateMutex );
+	if( mState == RUNNING ) {
+		mState = STOPPED;
 	}
 }
 
+float CinderNDIReceiver::getPoolServiceTime() const
+{
+	float serviceTime = 0.0f;
+	for( auto job : { mPoolVideoJob.get(), mPoolAudioJob.get(), mPoolMetadataJob.get() } ) {
+		if( job ) {
+			serviceTime += job->mAverageServiceTime;
+		}
+	}
+	return serviceTime;
+}
+
+CinderNDIReceiver::Stats CinderNDIReceiver::getStats() const
+{
+	Stats stats;
+	NDIlib_recv_performance_t total, dropped;
+	NDIlib_recv_get_performance( mNDIReceiver, &total, &dropped );
+	stats.mNumVideoFramesReceived = total.video_frames;
+	stats.mNumAudioFramesReceived = total.audio_frames;
+	stats.mNumMetadataFramesReceived = total.metadata_frames;
+	stats.mNumVideoFramesDroppedBySDK = dropped.video_frames;
+	stats.mNumAudioFramesDroppedBySDK = dropped.audio_frames;
+	stats.mNumMetadataFramesDroppedBySDK = dropped.metadata_frames;
+	NDIlib_recv_queue_t queued;
+	NDIlib_recv_get_queue( mNDIReceiver, &queued );
+	stats.mNumVideoFramesQueuedBySDK = queued.video_frames;
+	stats.mNumAudioFramesQueuedBySDK = queued.audio_frames;
+	stats.mNumMetadataFramesQueuedBySDK = queued.metadata_frames;
+	stats.mNumVideoFramesDropped = getNumVideoFramesDropped();
+	stats.mNumVideoFramesRepeated = mNumVideoFramesRepeated;
+	stats.mVideoQueueDepth = getVideoQueueDepth();
+	stats.mNumVideoFramesInFlight = getNumVideoFramesInFlight();
+	stats.mNumAudioUnderruns = mNumAudioUnderruns;
+	stats.mNumAudioOverruns = mNumAudioOverruns;
+	stats.mAudioResample = mResampleHistogram.getSummary();
+	stats.mAudioLatency = mAudioLatency;
+	stats.mAudioDriftPpm = mAudioDriftPpm;
+	stats.mAudioCorrectionPpm = mAudioCorrectionPpm;
+	stats.mAudioCorrectionFrames = mAudioCorrectionFrames;
+	stats.mNumAudioResyncs = mNumAudioResyncs;
+	stats.mCaptureWait = mCaptureWaitHistogram.getSummary();
+	stats.mWrap = mWrapHistogram.getSummary();
+	stats.mTextureCreate = mTextureCreateHistogram.getSummary();
+	stats.mFenceWait = mFenceWaitHistogram.getSummary();
+	stats.mQueueResidence = mVideoFramesBuffer->getResidenceHistogram().getSummary();
+	return stats;
+}
+
+void CinderNDIReceiver::resetStats()
+{
+	mCaptureWaitHistogram.reset();
+	mWrapHistogram.reset();
+	mTextureCreateHistogram.reset();
+	mFenceWaitHistogram.reset();
+	mResampleHistogram.reset();
+	mVideoFramesBuffer->getResidenceHistogram().reset();
+	mNumVideoFramesRepeated = 0;
+	mNumAudioUnderruns = 0;
+	mNumAudioOverruns = 0;
+	mNumAudioResyncs = 0;
+	mAudioCorrectionFrames = 0.0;
+}
+
 void CinderNDIReceiver::connect( const NDISource& source )
 {
 	NDIlib_recv_connect( mNDIReceiver, &source );
@@ -68,23 +253,78 @@ void CinderNDIReceiver::connect( const NDISource& source )
 void CinderNDIReceiver::disconnect()
 {
 	NDIlib_recv_connect( mNDIReceiver, nullptr );
+	mVideoFramesBuffer->clear();
+}
+
+bool CinderNDIReceiver::popVideoFrame()
+{
+	if( mVideoFramesBuffer->pop( &mCurrentVideoFrame ) ) {
+		return true;
+	}
+	if( mCurrentVideoFrame.mSize.x > 0 ) {
+		++mNumVideoFramesRepeated;
+	}
+	return false;
 }
 
 ci::gl::TextureRef CinderNDIReceiver::getVideoTexture()
 {
-	if( mVideoFramesBuffer->isNotEmpty() ) {
-		mVideoFramesBuffer->popBack( &mVideoTexture );
+	auto texture = mCurrentVideoFrame.mTexture;
+	if( popVideoFrame() && mReceiverDescription.mLazyUpload && mCurrentVideoFrame.mFrame ) {
+		auto uploadStart = std::chrono::high_resolution_clock::now();
+		CinderNDITextureLayout layout;
+		if( getNDITextureLayout( mCurrentVideoFrame.mFrame->getNDIVideoFrame(), &layout ) ) {
+			mCurrentVideoFrame.mTexture = uploadToPooledTexture( mTexturePool, mCurrentVideoFrame.mFrame->getNDIVideoFrame(), layout );
+			mTextureCreateHistogram.record( std::chrono::high_resolution_clock::now() - uploadStart );
+		}
+		else {
+			CI_LOG_W( "Unsupported video FourCC : " << mCurrentVideoFrame.mFourCC << ", keeping previous frame." );
+			mCurrentVideoFrame.mTexture = texture;
+		}
+		// The pixels are on the GPU now, hand the buffer back to the SDK right away.
+		describeVideoFrame( mCurrentVideoFrame.mFrame->getNDIVideoFrame(), true, &mCurrentVideoFrame );
+		mCurrentVideoFrame.mFrame.reset();
+		mVideoUploadTime = std::chrono::duration<float, std::milli>( std::chrono::high_resolution_clock::now() - uploadStart ).count();
 	}
-	return mVideoTexture;
+	return mCurrentVideoFrame.mTexture;
+}
+
+ci::Surface8uRef CinderNDIReceiver::getVideoSurface()
+{
+	popVideoFrame();
+	return mCurrentVideoFrame.mSurface;
+}
+
+NDIVideoFrameRef CinderNDIReceiver::getVideoFrame()
+{
+	popVideoFrame();
+	return mCurrentVideoFrame.mFrame;
 }
 
-void CinderNDIReceiver::receiveVideo()
+void CinderNDIReceiver::receiveVideo( uint32_t timeout )
 {
+	// Hand over any uploads that the GPU has finished with since the last time we checked.
+	if( mPboUploader ) {
+		while( auto tex = mPboUploader->popCompleted() ) {
+			auto entry = std::move( mPendingUploads.front() );
+			mPendingUploads.pop_front();
+			entry.mTexture = tex;
+			mVideoFramesBuffer->push( entry );
+		}
+	}
+	// Leave frames with the SDK while the consumer is holding on to too many of them.
+	if( mFrameTracker && ! mFrameTracker->waitForCapacity( timeout ) ) {
+		return;
+	}
 	NDIlib_video_frame_v2_t videoFrame;
 	// NDIlib_recv_capture_v2 should be safe to call at the same time from multiple threads according to the SDK.
 	// e.g To capture video and audio at the same time from separate threads for example.
-	// Wait max .5 sec for a new frame to arrive.
-	switch( NDIlib_recv_capture_v2( mNDIReceiver, &videoFrame, nullptr, nullptr, 500 ) ) { 
+	// The capture returns as soon as a frame arrives. Wait just briefly if there are uploads in flight that we need to poll.
+	if( mPboUploader && mPboUploader->hasPending() ) {
+		timeout = 1;
+	}
+	auto captureStart = std::chrono::steady_clock::now();
+	switch( NDIlib_recv_capture_v2( mNDIReceiver, &videoFrame, nullptr, nullptr, timeout ) ) { 
 		case NDIlib_frame_type_none:
 		{
 			CI_LOG_V( "No data available...." ); 
@@ -93,24 +333,50 @@ void CinderNDIReceiver::receiveVideo()
 		case NDIlib_frame_type_video:
 		{
 			CI_LOG_V( "Received video frame with resolution : ( " << videoFrame.xres << ", " << videoFrame.yres << " ) " );
-			auto surface = ci::Surface::create( videoFrame.p_data, videoFrame.xres, videoFrame.yres, videoFrame.line_stride_in_bytes, ci::SurfaceChannelOrder::RGBA );
-			auto tex = ci::gl::Texture::create( *surface );
-			auto fence = ci::gl::Sync::create();
-			fence->clientWaitSync();
-			mVideoFramesBuffer->pushFront( tex );
+			auto wrapStart = std::chrono::steady_clock::now();
+			mCaptureWaitHistogram.record( wrapStart - captureStart );
+			if( mFrameTracker ) {
+				CinderNDIVideoQueueEntry entry;
+				entry.mFrame = mFrameTracker->adopt( videoFrame );
+				describeVideoFrame( videoFrame, false, &entry );
+				mWrapHistogram.record( std::chrono::steady_clock::now() - wrapStart );
+				if( mReceiverDescription.mReceiverPool && mTexturePool && ! mReceiverDescription.mLazyUpload ) {
+					mReceiverDescription.mReceiverPool->queueUpload( mPoolVideoJob, entry.mFrame );
+				}
+				else {
+					mVideoFramesBuffer->push( entry );
+				}
+				break;
+			}
+			CinderNDITextureLayout layout;
+			if( ! getNDITextureLayout( videoFrame, &layout ) ) {
+				CI_LOG_W( "Unsupported video FourCC : " << videoFrame.FourCC << ", dropping video frame." );
+				NDIlib_recv_free_video_v2( mNDIReceiver, &videoFrame );
+				break;
+			}
+			auto uploadStart = std::chrono::high_resolution_clock::now();
+			if( mSurfacePool ) {
+				copyVideoFrame( videoFrame, layout );
+				mWrapHistogram.record( std::chrono::high_resolution_clock::now() - uploadStart );
+			}
+			else {
+				uploadVideoFrame( videoFrame, layout );
+			}
+			mVideoUploadTime = std::chrono::duration<float, std::milli>( std::chrono::high_resolution_clock::now() - uploadStart ).count();
 			NDIlib_recv_free_video_v2( mNDIReceiver, &videoFrame );
 			break;
 		}
 	}
 }
 
-void CinderNDIReceiver::receiveAudio()
+void CinderNDIReceiver::receiveAudio( uint32_t timeout )
 {
 	NDIlib_audio_frame_v2_t audioFrame;
+	NDIlib_metadata_frame_t metadataFrame;
 	// NDIlib_recv_capture_v2 should be safe to call at the same time from multiple threads according to the SDK.
 	// e.g To capture video and audio at the same time from separate threads for example.
-	// Wait max .5 sec for a new frame to arrive.
-	switch( NDIlib_recv_capture_v2( mNDIReceiver, nullptr, &audioFrame, nullptr, 50 ) ) { 
+	// The capture returns as soon as a frame arrives. Standalone metadata is picked up along with the audio.
+	switch( NDIlib_recv_capture_v2( mNDIReceiver, nullptr, &audioFrame, &metadataFrame, timeout ) ) { 
 		case NDIlib_frame_type_none:
 		{
 			CI_LOG_V( "No data available...." ); 
@@ -119,39 +385,326 @@ void CinderNDIReceiver::receiveAudio()
 		case NDIlib_frame_type_audio:
 		{
 			CI_LOG_V( "Received audio frame with no_samples : " << audioFrame.no_samples << " channels: " << audioFrame.no_channels << " channel stride: " << audioFrame.channel_stride_in_bytes ); 
-			{
-				std::lock_guard<std::mutex> lock( mAudioMutex );
-				if( ! mCurrentAudioBuffer || mCurrentAudioBuffer->getNumChannels() != audioFrame.no_channels ) {
-					auto framesPerBlock = ci::audio::Context::master()->getFramesPerBlock();
-					mCurrentAudioBuffer = std::make_shared<ci::audio::Buffer>( framesPerBlock, audioFrame.no_channels );
-					for( auto& buffer : mRingBuffers ) {
-						buffer.clear();
-					}
-					mRingBuffers.clear();
-					for( size_t ch = 0; ch < audioFrame.no_channels; ch++ ) {
-						mRingBuffers.emplace_back( audioFrame.no_samples * audioFrame.no_channels );
-					}
-				}
+			releaseAudioStreams();
+			const size_t numChannels = audioFrame.no_channels;
+			size_t numFrames = audioFrame.no_samples;
+			mAudioChannelData.resize( numChannels );
+			for( size_t ch = 0; ch < numChannels; ch++ ) {
+				mAudioChannelData[ch] = (const float*)( (const uint8_t*)audioFrame.p_data + ch * audioFrame.channel_stride_in_bytes );
 			}
-			for( size_t ch = 0; ch < audioFrame.no_channels; ch++ ) {
-				mRingBuffers[ch].write( audioFrame.p_data + ch * audioFrame.no_samples, audioFrame.no_samples );
+			const auto outputRate = ci::audio::Context::master()->getSampleRate();
+			const bool convertRate = mReceiverDescription.mResampleAudio && size_t( audioFrame.sample_rate ) != outputRate;
+			if( convertRate || mReceiverDescription.mAudioDriftCompensation ) {
+				numFrames = resampleAudio( numChannels, numFrames, convertRate ? audioFrame.sample_rate : int( outputRate ), outputRate );
 			}
+			else {
+				mResampler.reset();
+			}
+			const auto framesPerBlock = ci::audio::Context::master()->getFramesPerBlock();
+			// Below one received frame plus one block the audio thread would run dry between writes.
+			const size_t minTargetFrames = numFrames + framesPerBlock;
+			AudioStream* stream = mAudioStreams.empty() ? nullptr : mAudioStreams.back().get();
+			if( ! stream || stream->mRingBuffers.size() != numChannels || stream->mTargetFrames < minTargetFrames ) {
+				// Everything is allocated here, the audio thread only picks up the finished stream.
+				// Some headroom keeps resampled frame lengths from triggering a new stream every few frames.
+				const size_t targetFrames = mLatencyController.getTargetFrames( double( outputRate ), minTargetFrames + minTargetFrames / 8 );
+				auto newStream = std::make_unique<AudioStream>();
+				newStream->mBuffer = std::make_shared<ci::audio::Buffer>( framesPerBlock, numChannels );
+				newStream->mTargetFrames = targetFrames;
+				newStream->mScratch.resize( framesPerBlock );
+				for( size_t ch = 0; ch < numChannels; ch++ ) {
+					// Room for the target latency plus the overshoot allowed before frames are skipped.
+					newStream->mRingBuffers.emplace_back( targetFrames * 3 + numFrames * 2 );
+				}
+				stream = newStream.get();
+				mAudioStreams.push_back( std::move( newStream ) );
+				mPublishedAudioStream.store( stream, std::memory_order_release );
+			}
+			writeAudio( stream, numChannels, numFrames, stream->mTargetFrames, outputRate );
 			NDIlib_recv_free_audio_v2( mNDIReceiver, &audioFrame );
 			break;
 		}
+		case NDIlib_frame_type_metadata:
+		{
+			queueMetadata( metadataFrame );
+			NDIlib_recv_free_metadata( mNDIReceiver, &metadataFrame );
+			break;
+		}
+	}
+}
+
+void CinderNDIReceiver::receiveMetadata( uint32_t timeout )
+{
+	NDIlib_metadata_frame_t metadataFrame;
+	switch( NDIlib_recv_capture_v2( mNDIReceiver, nullptr, nullptr, &metadataFrame, timeout ) ) {
+		case NDIlib_frame_type_none:
+		{
+			CI_LOG_V( "No data available...." ); 
+			break;
+		}
+		case NDIlib_frame_type_metadata:
+		{
+			queueMetadata( metadataFrame );
+			NDIlib_recv_free_metadata( mNDIReceiver, &metadataFrame );
+			break;
+		}
+	}
+}
+
+void CinderNDIReceiver::queueMetadata( const NDIlib_metadata_frame_t& metadataFrame )
+{
+	auto slot = mMetadataQueue->beginPush();
+	if( ! slot ) {
+		++mNumMetadataFramesDropped;
+		return;
+	}
+	// Assigning reuses the storage the consumer swapped back into the slot.
+	const size_t length = metadataFrame.length > 0 ? size_t( metadataFrame.length - 1 ) : std::strlen( metadataFrame.p_data );
+	slot->mData.assign( metadataFrame.p_data, length );
+	slot->mTimecode = metadataFrame.timecode;
+	mMetadataQueue->commitPush();
+}
+
+void CinderNDIReceiver::describeVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, bool copyMetadata, CinderNDIVideoQueueEntry* entry )
+{
+	entry->mFourCC = videoFrame.FourCC;
+	entry->mSize = ci::ivec2( videoFrame.xres, videoFrame.yres );
+	entry->mTimecode = videoFrame.timecode;
+	if( copyMetadata && videoFrame.p_metadata ) {
+		entry->mMetadata.assign( videoFrame.p_metadata );
+	}
+	else {
+		entry->mMetadata.clear();
+	}
+}
+
+const char* CinderNDIReceiver::getVideoMetadata() const
+{
+	if( mCurrentVideoFrame.mFrame && mCurrentVideoFrame.mFrame->getMetadata() ) {
+		return mCurrentVideoFrame.mFrame->getMetadata();
+	}
+	return mCurrentVideoFrame.mMetadata.c_str();
+}
+
+bool CinderNDIReceiver::getMetadataFrame( CinderNDIMetadataFrame* frame )
+{
+	return mMetadataQueue && mMetadataQueue->tryPop( frame );
+}
+
+size_t CinderNDIReceiver::resampleAudio( size_t numChannels, size_t numFrames, int inputRate, size_t outputRate )
+{
+	if( ! mResampler || mResampler->getNumChannels() != numChannels ) {
+		mResampler = std::make_unique<CinderNDIResampler>( numChannels, mReceiverDescription.mResampleQuality );
+	}
+	mResampler->setRates( inputRate, outputRate );
+	mResampler->setRatioCorrection( mReceiverDescription.mAudioDriftCompensation ? mLatencyController.getCorrection() : 0.0 );
+	const size_t maxOutputFrames = mResampler->getMaxOutputFrames( numFrames );
+	mResampledAudio.resize( numChannels * maxOutputFrames );
+	auto resampleStart = std::chrono::steady_clock::now();
+	size_t numOutputFrames = 0;
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		float* output = mResampledAudio.data() + ch * maxOutputFrames;
+		numOutputFrames = mResampler->process( ch, mAudioChannelData[ch], numFrames, output );
+		mAudioChannelData[ch] = output;
+	}
+	mResampleHistogram.record( ( std::chrono::steady_clock::now() - resampleStart ) / numChannels );
+	return numOutputFrames;
+}
+
+void CinderNDIReceiver::writeAudio( AudioStream* stream, size_t numChannels, size_t numFrames, size_t targetFrames, size_t sampleRate )
+{
+	const size_t fill = stream->mRingBuffers[0].getAvailableRead();
+	if( fill == 0 ) {
+		// The audio thread ran dry ( or this is a new stream ), prime with silence to get back to the target right away.
+		if( mSilence.size() < targetFrames ) {
+			mSilence.resize( targetFrames, 0.0f );
+		}
+		const size_t primeFrames = targetFrames > numFrames ? targetFrames - numFrames : 0;
+		for( size_t ch = 0; ch < numChannels; ch++ ) {
+			stream->mRingBuffers[ch].write( mSilence.data(), primeFrames );
+		}
+		mLatencyController.reset( targetFrames );
+		++mNumAudioResyncs;
+	}
+	else if( fill > targetFrames * 2 + numFrames ) {
+		// Far above the target, e.g. after the audio device stalled. Skip the frame instead of adding latency.
+		mLatencyController.reset( targetFrames );
+		++mNumAudioResyncs;
+		return;
+	}
+	bool overrun = false;
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		// The ring buffer declines writes it has no room for, the whole frame is lost in that case.
+		overrun |= ! stream->mRingBuffers[ch].write( mAudioChannelData[ch], numFrames );
 	}
+	if( overrun ) {
+		++mNumAudioOverruns;
+	}
+	if( mReceiverDescription.mAudioDriftCompensation ) {
+		mLatencyController.update( stream->mRingBuffers[0].getAvailableRead(), numFrames, targetFrames, double( sampleRate ) );
+		const double correction = mLatencyController.getCorrection();
+		// Frames added ( positive ) or removed by the correction.
+		mAudioCorrectionFrames = mAudioCorrectionFrames + numFrames * -correction;
+		mAudioLatency = mLatencyController.getLatency();
+		mAudioDriftPpm = mLatencyController.getDriftPpm();
+		mAudioCorrectionPpm = float( correction * 1.0e6 );
+	}
+	else {
+		mAudioLatency = stream->mRingBuffers[0].getAvailableRead() * 1000.0f / sampleRate;
+	}
+}
+
+void CinderNDIReceiver::releaseAudioStreams()
+{
+	auto acquired = mAcquiredAudioStream.load( std::memory_order_acquire );
+	auto it = std::find_if( mAudioStreams.begin(), mAudioStreams.end(), [ acquired ] ( const std::unique_ptr<AudioStream>& stream ) { return stream.get() == acquired; } );
+	if( it != mAudioStreams.end() ) {
+		mAudioStreams.erase( mAudioStreams.begin(), it );
+	}
+}
+
+CinderNDIReceiver::AudioStream* CinderNDIReceiver::acquireAudioStream()
+{
+	// Switch to the newest layout. The acknowledgement is what allows the receive side to delete the previous stream.
+	auto published = mPublishedAudioStream.load( std::memory_order_acquire );
+	if( published != mCurrentAudioStream ) {
+		mCurrentAudioStream = published;
+		mAcquiredAudioStream.store( published, std::memory_order_release );
+	}
+	return mCurrentAudioStream;
 }
 
 ci::audio::BufferRef CinderNDIReceiver::getAudioBuffer()
 {
-	std::lock_guard<std::mutex> lock( mAudioMutex );
-	if( mCurrentAudioBuffer ) {
-		for( size_t ch = 0; ch < mCurrentAudioBuffer->getNumChannels(); ch++ ) {
-			if( ! mRingBuffers[ch].read( mCurrentAudioBuffer->getChannel( ch ), mCurrentAudioBuffer->getNumFrames() ) ) {
-				mCurrentAudioBuffer->zero();
+	if( ! acquireAudioStream() ) {
+		return nullptr;
+	}
+	auto& buffer = mCurrentAudioStream->mBuffer;
+	auto& rings = mCurrentAudioStream->mRingBuffers;
+	// Like readAudio(), nothing is read unless every channel holds the whole block, so channels never drift apart.
+	for( size_t ch = 0; ch < buffer->getNumChannels(); ch++ ) {
+		if( rings[ch].getAvailableRead() < buffer->getNumFrames() ) {
+			buffer->zero();
+			++mNumAudioUnderruns;
+			return buffer;
+		}
+	}
+	for( size_t ch = 0; ch < buffer->getNumChannels(); ch++ ) {
+		rings[ch].read( buffer->getChannel( ch ), buffer->getNumFrames() );
+	}
+	return buffer;
+}
+
+bool CinderNDIReceiver::readAudio( ci::audio::Buffer* buffer )
+{
+	auto stream = acquireAudioStream();
+	const size_t numFrames = buffer->getNumFrames();
+	if( ! stream ) {
+		buffer->zero();
+		return false;
+	}
+	auto& rings = stream->mRingBuffers;
+	const size_t numInputChannels = rings.size();
+	const size_t numOutputChannels = buffer->getNumChannels();
+	// Channels are written one after the other, only read once all of them hold the whole block.
+	for( auto& ring : rings ) {
+		if( ring.getAvailableRead() < numFrames ) {
+			buffer->zero();
+			++mNumAudioUnderruns;
+			return false;
+		}
+	}
+	if( numOutputChannels >= numInputChannels ) {
+		for( size_t ch = 0; ch < numInputChannels; ch++ ) {
+			rings[ch].read( buffer->getChannel( ch ), numFrames );
+		}
+		// More output channels repeat the received ones, e.g. mono to both sides of a stereo output.
+		for( size_t ch = numInputChannels; ch < numOutputChannels; ch++ ) {
+			std::memcpy( buffer->getChannel( ch ), buffer->getChannel( ch % numInputChannels ), numFrames * sizeof( float ) );
+		}
+		return true;
+	}
+	// Fewer output channels average the received channels that map onto them, received channel ch goes to ch % numOutputChannels.
+	buffer->zero();
+	auto& scratch = stream->mScratch;
+	for( size_t offset = 0; offset < numFrames; offset += scratch.size() ) {
+		const size_t count = std::min( scratch.size(), numFrames - offset );
+		for( size_t ch = 0; ch < numInputChannels; ch++ ) {
+			rings[ch].read( scratch.data(), count );
+			const size_t outputChannel = ch % numOutputChannels;
+			const float gain = 1.0f / ( ( numInputChannels - outputChannel + numOutputChannels - 1 ) / numOutputChannels );
+			float* output = buffer->getChannel( outputChannel ) + offset;
+			for( size_t i = 0; i < count; i++ ) {
+				output[i] += scratch[i] * gain;
 			}
 		}
 	}
-	return mCurrentAudioBuffer;
+	return true;
 }
 
+
+void CinderNDIReceiver::uploadVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout )
+{
+	CinderNDIVideoQueueEntry entry;
+	describeVideoFrame( videoFrame, true, &entry );
+	if( mPboUploader ) {
+		auto uploadStart = std::chrono::steady_clock::now();
+		const bool uploaded = mPboUploader->upload( videoFrame.p_data, layout, videoFrame.line_stride_in_bytes );
+		mTextureCreateHistogram.record( std::chrono::steady_clock::now() - uploadStart );
+		if( uploaded ) {
+			mPendingUploads.push_back( entry );
+		}
+		else {
+			CI_LOG_V( "All pixel-unpack buffers are in flight, dropping video frame." );
+		}
+		return;
+	}
+	auto uploadStart = std::chrono::steady_clock::now();
+	entry.mTexture = uploadToPooledTexture( mTexturePool, videoFrame, layout );
+	auto fenceStart = std::chrono::steady_clock::now();
+	mTextureCreateHistogram.record( fenceStart - uploadStart );
+	// The texture is consumed on another context, make sure the upload has landed before handing it over.
+	auto fence = ci::gl::Sync::create();
+	fence->clientWaitSync();
+	mFenceWaitHistogram.record( std::chrono::steady_clock::now() - fenceStart );
+	mVideoFramesBuffer->push( entry );
+}
+
+void CinderNDIReceiver::deliverVideoFrame( const CinderNDIVideoQueueEntry& entry, float uploadTime )
+{
+	mVideoUploadTime = uploadTime;
+	mTextureCreateHistogram.record( uploadTime );
+	mVideoFramesBuffer->push( entry );
+}
+
+ci::gl::TextureRef CinderNDIReceiver::uploadToPooledTexture( const CinderNDITexturePoolRef& texturePool, const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout )
+{
+	auto tex = texturePool->acquire( layout.mWidth, layout.mHeight, layout.mInternalFormat );
+	ci::gl::ScopedTextureBind scopedTex( tex );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+	glPixelStorei( GL_UNPACK_ROW_LENGTH, videoFrame.line_stride_in_bytes / 4 );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, layout.mWidth, layout.mHeight, layout.mDataFormat, GL_UNSIGNED_BYTE, videoFrame.p_data );
+	glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+	return tex;
+}
+
+void CinderNDIReceiver::copyVideoFrame( const NDIlib_video_frame_v2_t& videoFrame, const CinderNDITextureLayout& layout )
+{
+	CinderNDIVideoQueueEntry entry;
+	entry.mSurface = mSurfacePool->acquire( layout.mWidth, layout.mHeight, getNDISurfaceChannelOrder( videoFrame.FourCC ) );
+	describeVideoFrame( videoFrame, true, &entry );
+	const size_t srcRowBytes = videoFrame.line_stride_in_bytes;
+	const size_t dstRowBytes = entry.mSurface->getRowBytes();
+	const size_t rowBytes = std::min( srcRowBytes, dstRowBytes );
+	const uint8_t* src = videoFrame.p_data;
+	uint8_t* dst = entry.mSurface->getData();
+	if( srcRowBytes == dstRowBytes ) {
+		std::memcpy( dst, src, srcRowBytes * layout.mHeight );
+	}
+	else {
+		for( int row = 0; row < layout.mHeight; ++row ) {
+			std::memcpy( dst + row * dstRowBytes, src + row * srcRowBytes, rowBytes );
+		}
+	}
+	mVideoFramesBuffer->push( entry );
+}
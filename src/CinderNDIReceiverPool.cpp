@@ -0,0 +1,274 @@
+#include "CinderNDIReceiverPool.h"
+#include "CinderNDIReceiver.h"
+#include <algorithm>
+#define CI_MIN_LOG_LEVEL 2
+#include "cinder/Log.h"
+#include "cinder/gl/Sync.h"
+
+namespace {
+// Weight of the newest sample in the running averages reported by the stats.
+const float AVERAGE_WEIGHT = 0.05f;
+
+float toMilliseconds( std::chrono::steady_clock::duration duration )
+{
+	return std::chrono::duration<float, std::milli>( duration ).count();
+}
+
+void accumulate( std::atomic<float>& average, float sample )
+{
+	float current = average;
+	average = current + ( sample - current ) * AVERAGE_WEIGHT;
+}
+
+void accumulateMax( std::atomic<float>& maximum, float sample )
+{
+	float current = maximum;
+	while( sample > current && ! maximum.compare_exchange_weak( current, sample ) ) {}
+}
+} // anonymous namespace
+
+CinderNDIReceiverPool::CinderNDIReceiverPool( const Description& dscr )
+: mDescription( dscr )
+{
+	if( mDescription.mUploadTextures ) {
+		auto ctx = ci::gl::Context::create( ci::gl::context() );
+		mUploadThread = std::make_unique<std::thread>( std::bind( &CinderNDIReceiverPool::uploadThread, this, ctx ) );
+	}
+	for( size_t i = 0; i < std::max<size_t>( mDescription.mNumWorkers, 1 ); ++i ) {
+		mWorkers.emplace_back( std::bind( &CinderNDIReceiverPool::workerThread, this ) );
+	}
+}
+
+CinderNDIReceiverPool::~CinderNDIReceiverPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mExiting = true;
+	}
+	mRunQueueCond.notify_all();
+	{
+		std::lock_guard<std::mutex> lock( mUploadMutex );
+	}
+	mUploadCond.notify_all();
+	for( auto& worker : mWorkers ) {
+		worker.join();
+	}
+	if( mUploadThread ) {
+		mUploadThread->join();
+	}
+	if( ! mJobs.empty() ) {
+		CI_LOG_W( "Receiver pool destroyed while " << getNumReceivers() << " receivers still use it." );
+	}
+}
+
+CinderNDIReceiverPool::JobRef CinderNDIReceiverPool::add( CinderNDIReceiver* receiver, Job::Kind kind )
+{
+	auto job = std::make_shared<Job>();
+	job->mReceiver = receiver;
+	job->mKind = kind;
+	std::lock_guard<std::mutex> lock( mMutex );
+	mJobs.push_back( job );
+	mParkedJobs.push_back( job );
+	return job;
+}
+
+void CinderNDIReceiverPool::remove( CinderNDIReceiver* receiver )
+{
+	std::vector<JobRef> removed;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		auto belongs = [ receiver ] ( const JobRef& job ) { return job->mReceiver == receiver; };
+		std::copy_if( mJobs.begin(), mJobs.end(), std::back_inserter( removed ), belongs );
+		mJobs.erase( std::remove_if( mJobs.begin(), mJobs.end(), belongs ), mJobs.end() );
+		mRunQueue.erase( std::remove_if( mRunQueue.begin(), mRunQueue.end(), belongs ), mRunQueue.end() );
+		mParkedJobs.erase( std::remove_if( mParkedJobs.begin(), mParkedJobs.end(), belongs ), mParkedJobs.end() );
+		for( auto& job : removed ) {
+			job->mRemoved = true;
+		}
+	}
+	// Wait for a worker or the upload thread that might still be busy with the receiver.
+	for( auto& job : removed ) {
+		std::lock_guard<std::mutex> serviceLock( job->mMutex );
+		std::lock_guard<std::mutex> deliveryLock( job->mDeliveryMutex );
+		job->mReceiver = nullptr;
+	}
+}
+
+void CinderNDIReceiverPool::resume( CinderNDIReceiver* receiver )
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		auto now = std::chrono::steady_clock::now();
+		for( auto it = mParkedJobs.begin(); it != mParkedJobs.end(); ) {
+			if( (*it)->mReceiver == receiver ) {
+				(*it)->mReadyTime = now;
+				mRunQueue.push_back( *it );
+				it = mParkedJobs.erase( it );
+			}
+			else {
+				++it;
+			}
+		}
+	}
+	mRunQueueCond.notify_all();
+}
+
+void CinderNDIReceiverPool::queueUpload( const JobRef& job, const NDIVideoFrameRef& frame )
+{
+	{
+		std::lock_guard<std::mutex> lock( mUploadMutex );
+		mUploads.push_back( { job, frame } );
+	}
+	mUploadCond.notify_one();
+}
+
+CinderNDIReceiverPool::Stats CinderNDIReceiverPool::getStats() const
+{
+	Stats stats;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		stats.mNumReceivers = getNumReceivers();
+	}
+	{
+		std::lock_guard<std::mutex> lock( mUploadMutex );
+		stats.mUploadQueueDepth = mUploads.size();
+	}
+	stats.mNumWorkers = mWorkers.size();
+	stats.mNumServiced = mNumServiced;
+	stats.mAverageSchedulingLatency = mAverageSchedulingLatency;
+	stats.mMaxSchedulingLatency = mMaxSchedulingLatency;
+	stats.mAverageUploadBatchTime = mAverageUploadBatchTime;
+	return stats;
+}
+
+size_t CinderNDIReceiverPool::getNumReceivers() const
+{
+	// A receiver has one job per media type it receives.
+	std::vector<const CinderNDIReceiver*> receivers;
+	for( const auto& job : mJobs ) {
+		receivers.push_back( job->mReceiver );
+	}
+	std::sort( receivers.begin(), receivers.end() );
+	return std::unique( receivers.begin(), receivers.end() ) - receivers.begin();
+}
+
+void CinderNDIReceiverPool::workerThread()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	while( true ) {
+		mRunQueueCond.wait( lock, [ this ] { return mExiting || ! mRunQueue.empty(); } );
+		if( mExiting ) {
+			return;
+		}
+		// Jobs go back to the end of the queue after every pass, so receivers are serviced round-robin.
+		auto job = mRunQueue.front();
+		mRunQueue.pop_front();
+		lock.unlock();
+
+		auto serviceStart = std::chrono::steady_clock::now();
+		const float latency = toMilliseconds( serviceStart - job->mReadyTime );
+		accumulate( mAverageSchedulingLatency, latency );
+		accumulateMax( mMaxSchedulingLatency, latency );
+		{
+			std::lock_guard<std::mutex> serviceLock( job->mMutex );
+			if( job->mReceiver ) {
+				switch( job->mKind ) {
+					case Job::VIDEO:
+					{
+						job->mReceiver->receiveVideo( mDescription.mCaptureTimeout );
+						break;
+					}
+					case Job::AUDIO:
+					{
+						job->mReceiver->receiveAudio( mDescription.mCaptureTimeout );
+						break;
+					}
+					case Job::METADATA:
+					{
+						job->mReceiver->receiveMetadata( mDescription.mCaptureTimeout );
+						break;
+					}
+				}
+				accumulate( job->mAverageServiceTime, toMilliseconds( std::chrono::steady_clock::now() - serviceStart ) );
+				++mNumServiced;
+			}
+		}
+
+		lock.lock();
+		// Not removed yet means the receiver is still alive, remove() needs the lock we are holding.
+		if( job->mRemoved ) {
+			continue;
+		}
+		if( ! job->mReceiver->isRunning() ) {
+			mParkedJobs.push_back( job );
+			continue;
+		}
+		job->mReadyTime = std::chrono::steady_clock::now();
+		mRunQueue.push_back( job );
+	}
+}
+
+void CinderNDIReceiverPool::uploadThread( ci::gl::ContextRef ctx )
+{
+	ctx->makeCurrent();
+	struct Delivery {
+		JobRef						mJob;
+		CinderNDIVideoQueueEntry	mEntry;
+	};
+	std::deque<Upload> batch;
+	std::vector<Delivery> deliveries;
+	while( true ) {
+		{
+			std::unique_lock<std::mutex> lock( mUploadMutex );
+			mUploadCond.wait( lock, [ this ] { return mExiting || ! mUploads.empty(); } );
+			if( mExiting ) {
+				break;
+			}
+			std::swap( batch, mUploads );
+		}
+		auto batchStart = std::chrono::steady_clock::now();
+		for( auto& upload : batch ) {
+			CinderNDITexturePoolRef texturePool;
+			{
+				std::lock_guard<std::mutex> deliveryLock( upload.mJob->mDeliveryMutex );
+				if( upload.mJob->mReceiver ) {
+					texturePool = upload.mJob->mReceiver->getTexturePool();
+				}
+			}
+			if( ! texturePool ) {
+				continue;
+			}
+			const auto& videoFrame = upload.mFrame->getNDIVideoFrame();
+			CinderNDITextureLayout layout;
+			if( ! getNDITextureLayout( videoFrame, &layout ) ) {
+				CI_LOG_W( "Unsupported video FourCC : " << videoFrame.FourCC << ", dropping video frame." );
+				continue;
+			}
+			Delivery delivery;
+			delivery.mJob = upload.mJob;
+			delivery.mEntry.mTexture = CinderNDIReceiver::uploadToPooledTexture( texturePool, videoFrame, layout );
+			CinderNDIReceiver::describeVideoFrame( videoFrame, true, &delivery.mEntry );
+			deliveries.push_back( std::move( delivery ) );
+		}
+		// The pixels have been copied by the driver, hand the buffers back to the SDK before waiting on the GPU.
+		batch.clear();
+		if( ! deliveries.empty() ) {
+			// A single fence covers every upload of the batch.
+			auto fence = ci::gl::Sync::create();
+			fence->clientWaitSync();
+			const float batchTime = toMilliseconds( std::chrono::steady_clock::now() - batchStart );
+			accumulate( mAverageUploadBatchTime, batchTime );
+			for( auto& delivery : deliveries ) {
+				std::lock_guard<std::mutex> deliveryLock( delivery.mJob->mDeliveryMutex );
+				if( delivery.mJob->mReceiver ) {
+					delivery.mJob->mReceiver->deliverVideoFrame( delivery.mEntry, batchTime / deliveries.size() );
+				}
+			}
+			deliveries.clear();
+		}
+	}
+	// Release anything still queued while the context is current.
+	batch.clear();
+	std::lock_guard<std::mutex> lock( mUploadMutex );
+	mUploads.clear();
+}
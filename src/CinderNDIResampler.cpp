@@ -0,0 +1,198 @@
+#include "CinderNDIResampler.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+	#include <xmmintrin.h>
+	#define CINDER_NDI_RESAMPLER_SSE
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#include <arm_neon.h>
+	#define CINDER_NDI_RESAMPLER_NEON
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+double besselI0( double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for( int k = 1; k < 32; ++k ) {
+		term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+		sum += term;
+		if( term < sum * 1e-12 ) {
+			break;
+		}
+	}
+	return sum;
+}
+
+// Both rows must hold numTaps coefficients, numTaps is a multiple of 4.
+void dotProduct2( const float* x, const float* a, const float* b, size_t numTaps, float* outA, float* outB )
+{
+#if defined( CINDER_NDI_RESAMPLER_SSE )
+	__m128 sumA = _mm_setzero_ps();
+	__m128 sumB = _mm_setzero_ps();
+	for( size_t i = 0; i < numTaps; i += 4 ) {
+		const __m128 v = _mm_loadu_ps( x + i );
+		sumA = _mm_add_ps( sumA, _mm_mul_ps( v, _mm_loadu_ps( a + i ) ) );
+		sumB = _mm_add_ps( sumB, _mm_mul_ps( v, _mm_loadu_ps( b + i ) ) );
+	}
+	alignas( 16 ) float lanesA[4], lanesB[4];
+	_mm_store_ps( lanesA, sumA );
+	_mm_store_ps( lanesB, sumB );
+	*outA = ( lanesA[0] + lanesA[1] ) + ( lanesA[2] + lanesA[3] );
+	*outB = ( lanesB[0] + lanesB[1] ) + ( lanesB[2] + lanesB[3] );
+#elif defined( CINDER_NDI_RESAMPLER_NEON )
+	float32x4_t sumA = vdupq_n_f32( 0.0f );
+	float32x4_t sumB = vdupq_n_f32( 0.0f );
+	for( size_t i = 0; i < numTaps; i += 4 ) {
+		const float32x4_t v = vld1q_f32( x + i );
+		sumA = vmlaq_f32( sumA, v, vld1q_f32( a + i ) );
+		sumB = vmlaq_f32( sumB, v, vld1q_f32( b + i ) );
+	}
+	const float32x2_t pairA = vadd_f32( vget_low_f32( sumA ), vget_high_f32( sumA ) );
+	const float32x2_t pairB = vadd_f32( vget_low_f32( sumB ), vget_high_f32( sumB ) );
+	*outA = vget_lane_f32( vpadd_f32( pairA, pairA ), 0 );
+	*outB = vget_lane_f32( vpadd_f32( pairB, pairB ), 0 );
+#else
+	float sumA = 0.0f, sumB = 0.0f;
+	for( size_t i = 0; i < numTaps; ++i ) {
+		sumA += x[i] * a[i];
+		sumB += x[i] * b[i];
+	}
+	*outA = sumA;
+	*outB = sumB;
+#endif
+}
+
+} // anonymous namespace
+
+CinderNDIResampler::CinderNDIResampler( size_t numChannels, Quality quality )
+: mQuality( quality ), mChannels( numChannels )
+{
+	switch( quality ) {
+		case FAST:
+		{
+			mNumTaps = 8;
+			mNumPhases = 32;
+			mRolloff = 0.85f;
+			mKaiserBeta = 6.0f;
+			break;
+		}
+		case MEDIUM:
+		{
+			mNumTaps = 16;
+			mNumPhases = 64;
+			mRolloff = 0.9f;
+			mKaiserBeta = 8.0f;
+			break;
+		}
+		default:
+		{
+			mNumTaps = 32;
+			mNumPhases = 256;
+			mRolloff = 0.94f;
+			mKaiserBeta = 10.0f;
+			break;
+		}
+	}
+	reset();
+}
+
+void CinderNDIResampler::setRates( double inputRate, double outputRate )
+{
+	if( inputRate == mInputRate && outputRate == mOutputRate ) {
+		return;
+	}
+	mInputRate = inputRate;
+	mOutputRate = outputRate;
+	mStep = inputRate / outputRate * ( 1.0 + mCorrection );
+	buildFilter();
+}
+
+void CinderNDIResampler::setRatioCorrection( double correction )
+{
+	mCorrection = correction;
+	if( mOutputRate > 0.0 ) {
+		mStep = mInputRate / mOutputRate * ( 1.0 + mCorrection );
+	}
+}
+
+void CinderNDIResampler::buildFilter()
+{
+	// Low-pass below the lower of both Nyquist frequencies, in cycles per input frame.
+	const double cutoff = 0.5 * std::min( 1.0, 1.0 / mStep ) * mRolloff;
+	const double halfLength = mNumTaps / 2.0;
+	const double windowNorm = besselI0( mKaiserBeta );
+	mCoefficients.assign( ( mNumPhases + 1 ) * mNumTaps, 0.0f );
+	for( size_t phase = 0; phase <= mNumPhases; ++phase ) {
+		float* row = &mCoefficients[phase * mNumTaps];
+		double sum = 0.0;
+		for( size_t tap = 0; tap < mNumTaps; ++tap ) {
+			// Distance between the output position and the input frame this tap is applied to.
+			const double distance = double( phase ) / mNumPhases + halfLength - 1.0 - tap;
+			const double x = 2.0 * cutoff * distance;
+			const double sinc = x == 0.0 ? 1.0 : std::sin( PI * x ) / ( PI * x );
+			const double r = distance / halfLength;
+			const double window = std::abs( r ) >= 1.0 ? 0.0 : besselI0( mKaiserBeta * std::sqrt( 1.0 - r * r ) ) / windowNorm;
+			row[tap] = float( sinc * window );
+			sum += row[tap];
+		}
+		// Unity gain at DC for every phase.
+		for( size_t tap = 0; tap < mNumTaps; ++tap ) {
+			row[tap] = float( row[tap] / sum );
+		}
+	}
+}
+
+size_t CinderNDIResampler::getMaxOutputFrames( size_t numInputFrames ) const
+{
+	return size_t( std::ceil( ( numInputFrames + mNumTaps ) / mStep ) ) + 1;
+}
+
+size_t CinderNDIResampler::process( size_t channel, const float* input, size_t numInputFrames, float* output )
+{
+	auto& state = mChannels[channel];
+	if( state.mHistory.size() < state.mNumFrames + numInputFrames ) {
+		state.mHistory.resize( state.mNumFrames + numInputFrames );
+	}
+	std::memcpy( state.mHistory.data() + state.mNumFrames, input, numInputFrames * sizeof( float ) );
+	state.mNumFrames += numInputFrames;
+
+	const float* history = state.mHistory.data();
+	double time = state.mTime;
+	size_t numOutputFrames = 0;
+	while( true ) {
+		const size_t index = size_t( time );
+		if( index + mNumTaps > state.mNumFrames ) {
+			break;
+		}
+		const double phase = ( time - index ) * mNumPhases;
+		const size_t row = size_t( phase );
+		const float alpha = float( phase - row );
+		float a, b;
+		dotProduct2( history + index, &mCoefficients[row * mNumTaps], &mCoefficients[( row + 1 ) * mNumTaps], mNumTaps, &a, &b );
+		output[numOutputFrames++] = a + ( b - a ) * alpha;
+		time += mStep;
+	}
+	// Keep what the next call still needs.
+	const size_t consumed = std::min( size_t( time ), state.mNumFrames );
+	std::memmove( state.mHistory.data(), history + consumed, ( state.mNumFrames - consumed ) * sizeof( float ) );
+	state.mNumFrames -= consumed;
+	state.mTime = time - consumed;
+	return numOutputFrames;
+}
+
+void CinderNDIResampler::reset()
+{
+	for( auto& state : mChannels ) {
+		// Pad with half a window of silence so the first output frame lines up with the first input frame.
+		state.mHistory.assign( mNumTaps / 2 - 1, 0.0f );
+		state.mNumFrames = mNumTaps / 2 - 1;
+		state.mTime = 0.0;
+	}
+}
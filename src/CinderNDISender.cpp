@@ -2,8 +2,19 @@
 #include "cinder/Log.h"
 #include "cinder/Surface.h"
 #include "cinder/ip/Flip.h"
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <algorithm>
 #include "Processing.NDI.Lib.h"
 
+namespace {
+
+// Row alignment of pooled surfaces, a cache line keeps rows friendly to the SDK's and our own SIMD conversion.
+const size_t SURFACE_ROW_ALIGNMENT = 64;
+
+} // anonymous namespace
+
 CinderNDISender::CinderNDISender( const Description dscr )
 : mSenderDescription( dscr )
 {
@@ -22,10 +33,42 @@ CinderNDISender::CinderNDISender( const Description dscr )
 		connectionMeta.p_data = cstr.data(); 
 		NDIlib_send_add_connection_metadata( mNDISender, &connectionMeta );
 	}
+	mNumConnections = NDIlib_send_get_no_connections( mNDISender, 0 );
+	mConnectionThread = std::make_unique<std::thread>( std::bind( &CinderNDISender::connectionThread, this ) );
+	if( auto app = ci::app::AppBase::get() ) {
+		mAppConnectionUpdate = app->getSignalUpdate().connect( std::bind( &CinderNDISender::update, this ) );
+	}
+	mSurfacePool = CinderNDISurfacePool::create( SURFACE_ROW_ALIGNMENT );
+	mPboReader = std::make_unique<CinderNDIPboReader>( mSenderDescription.mReadbackRingSize, mSurfacePool );
+	if( mSenderDescription.mVideoFormat != SURFACE ) {
+		mEncoder = std::make_unique<CinderNDIUYVYEncoder>( mSenderDescription.mColorSpace, mSenderDescription.mEncoderKernel );
+	}
+	if( mSenderDescription.mThreaded || mEncoder ) {
+		mSendThread = std::make_unique<std::thread>( std::bind( &CinderNDISender::sendThread, this ) );
+	}
+	// Audio gets its own thread, clocked audio and clocked video waiting on the same one would add up to twice a frame.
+	if( mSenderDescription.mThreaded ) {
+		mAudioSendThread = std::make_unique<std::thread>( std::bind( &CinderNDISender::audioSendThread, this ) );
+	}
 }
 
 CinderNDISender::~CinderNDISender()
 {
+	if( mSendThread ) {
+		{
+			std::lock_guard<std::mutex> lock( mQueueMutex );
+			mSendThreadExiting = true;
+		}
+		mQueueCondition.notify_all();
+		mSendThread->join();
+	}
+	if( mAudioSendThread ) {
+		mAudioSendThread->join();
+	}
+	mAppConnectionUpdate.disconnect();
+	// Returns within one poll interval.
+	mConnectionThreadExiting = true;
+	mConnectionThread->join();
 	if( mNDISender ) {
 		// Will also flush any pending video frames from async transimission.
 		NDIlib_send_destroy( mNDISender );
@@ -40,10 +83,49 @@ void CinderNDISender::sendAudio( ci::audio::Buffer* audioBuffer, const AudioFram
 	if( ! mNDISender || ! audioBuffer )
 		return;
 
-	if( NDIlib_send_get_no_connections( mNDISender, 0 ) ) {
+	if( mSenderDescription.mThreaded ) {
+		if( ! hasConnections() ) {
+			return;
+		}
+		{
+			std::unique_lock<std::mutex> lock( mQueueMutex );
+			const size_t capacity = std::max<size_t>( mSenderDescription.mAudioQueueSize, 1 );
+			if( mSenderDescription.mQueuePolicy == BLOCK ) {
+				mQueueCondition.wait( lock, [this, capacity] { return mAudioJobs.size() < capacity; } );
+			}
+			while( mAudioJobs.size() >= capacity ) {
+				mFreeAudioJobs.push_back( std::move( mAudioJobs.front() ) );
+				mAudioJobs.pop_front();
+				++mNumAudioFramesDropped;
+			}
+			// Jobs are recycled so their buffers only grow, copying does not allocate once the frame size settles.
+			AudioJobPtr job;
+			if( ! mFreeAudioJobs.empty() ) {
+				job = std::move( mFreeAudioJobs.back() );
+				mFreeAudioJobs.pop_back();
+			}
+			else {
+				job = std::make_unique<AudioJob>();
+			}
+			job->mBuffer.setSize( audioBuffer->getNumFrames(), audioBuffer->getNumChannels() );
+			job->mBuffer.copy( *audioBuffer );
+			job->mParams = audioFrameParams != nullptr ? *audioFrameParams : AudioFrameParams();
+			mAudioJobs.push_back( std::move( job ) );
+		}
+		mQueueCondition.notify_all();
+		return;
+	}
+	sendAudioFrame( audioBuffer, audioFrameParams );
+}
+
+void CinderNDISender::sendAudioFrame( ci::audio::Buffer* audioBuffer, const AudioFrameParams* audioFrameParams )
+{
+	if( hasConnections() ) {
 		auto audioFrame = createAudioFrameFromBuffer( audioBuffer, audioFrameParams );
 		if( audioFrame.p_data != nullptr ) {
+			auto start = std::chrono::steady_clock::now();
 			NDIlib_send_send_audio_v2( mNDISender, &audioFrame );
+			mAudioSendHistogram.record( std::chrono::steady_clock::now() - start );
 		}
 	}
 }
@@ -65,25 +147,516 @@ NDIAudioFrame CinderNDISender::createAudioFrameFromBuffer( ci::audio::Buffer* au
 }
 
 void CinderNDISender::sendSurface( ci::Surface* surface, const VideoFrameParams* videoFrameParams )
+{
+	if( ! skipOffAirFrame() ) {
+		sendSurface( surface, videoFrameParams, nullptr );
+	}
+}
+
+void CinderNDISender::sendSurface( const ci::Surface8uRef& surface, const VideoFrameParams* videoFrameParams )
+{
+	if( ! skipOffAirFrame() ) {
+		sendSurface( surface.get(), videoFrameParams, surface );
+	}
+}
+
+ci::Surface8uRef CinderNDISender::acquireSurface( int width, int height, ci::SurfaceChannelOrder channelOrder )
+{
+	return mSurfacePool->acquire( width, height, channelOrder );
+}
+
+void CinderNDISender::sendSurface( ci::Surface* surface, const VideoFrameParams* videoFrameParams, ci::Surface8uRef keepAlive )
 {
 	if( ! mNDISender || ! surface )
 		return;
 
 	mFps = videoFrameParams != nullptr ? float( videoFrameParams->mFrameRateNumerator ) / float( videoFrameParams->mFrameRateDenomenator ) : DEFAULT_FPS; 
 
-	if( NDIlib_send_get_no_connections( mNDISender, 0 ) ) {
-		// Check to see if we have received any connection metadata from the receiver side
-		NDIConnectionMeta rcvMeta;
-		if( NDIlib_send_capture( mNDISender, &rcvMeta, 0 ) ) {
-			CI_LOG_I( "Got meta from receiver: " << rcvMeta.p_data );
-			NDIlib_send_free_metadata( mNDISender, &rcvMeta );
+	if( mSenderDescription.mThreaded ? ! hasConnections() : ! checkConnections() ) {
+		return;
+	}
+	// Off air frames go out smaller and announce the rate they are actually sent at.
+	VideoFrameParams offAirParams;
+	if( isReducingQuality() ) {
+		offAirParams = videoFrameParams != nullptr ? *videoFrameParams : VideoFrameParams();
+		offAirParams.mFrameRateDenomenator *= std::max( mSenderDescription.mOffAirFrameInterval, 1 );
+		videoFrameParams = &offAirParams;
+		if( auto downscaled = downscaleOffAir( *surface ) ) {
+			keepAlive = downscaled;
+			surface = keepAlive.get();
+		}
+	}
+
+	const bool convert = mEncoder && surface->getWidth() % 2 == 0;
+	if( mSenderDescription.mThreaded ) {
+		VideoJob job;
+		// Raw surfaces are copied since the caller may reuse them as soon as this returns.
+		job.mSurfaceRef = keepAlive ? keepAlive : copySurface( *surface );
+		job.mSurface = job.mSurfaceRef.get();
+		job.mParams = videoFrameParams != nullptr ? *videoFrameParams : VideoFrameParams();
+		queueVideoJob( std::move( job ) );
+		return;
+	}
+	if( convert ) {
+		VideoJob job;
+		job.mSurface = surface;
+		job.mSurfaceRef = keepAlive;
+		job.mParams = videoFrameParams != nullptr ? *videoFrameParams : VideoFrameParams();
+		queueVideoJob( std::move( job ) );
+		return;
+	}
+	auto videoFrame = createVideoFrameFromSurface( surface, videoFrameParams );	
+	if( videoFrame.p_data != nullptr ) {
+		// The parameters may be the off air copy on the stack, the metadata has to outlive this call.
+		sendVideoAsync( videoFrame, keepAlive, videoFrameParams != nullptr ? videoFrameParams->mMetadata : std::string() );
+	}
+}
+
+void CinderNDISender::sendTexture( const ci::gl::FboRef& fbo, const VideoFrameParams* videoFrameParams )
+{
+	if( fbo ) {
+		// Also resolves multisampled framebuffers.
+		sendTexture( fbo->getColorTexture(), videoFrameParams );
+	}
+}
+
+void CinderNDISender::sendTexture( const ci::gl::TextureRef& texture, const VideoFrameParams* videoFrameParams )
+{
+	if( ! mNDISender || ! texture )
+		return;
+
+	sendCompletedReadbacks( false );
+	// Nobody would see the frame, skip the readback altogether.
+	if( ! hasConnections() || skipOffAirFrame() ) {
+		return;
+	}
+	if( mPboReader->isFull() ) {
+		sendCompletedReadbacks( true );
+	}
+	if( mPboReader->read( texture ) ) {
+		mReadbackParams.push_back( videoFrameParams != nullptr ? *videoFrameParams : VideoFrameParams() );
+	}
+}
+
+void CinderNDISender::sendCompletedReadbacks( bool wait )
+{
+	while( mPboReader->hasPending() ) {
+		const size_t numPending = mPboReader->getNumPending();
+		auto surface = mPboReader->popCompleted( wait );
+		if( mPboReader->getNumPending() == numPending ) {
+			break;
+		}
+		// Readbacks that failed still leave the ring, their parameters are dropped along with them.
+		auto params = std::move( mReadbackParams.front() );
+		mReadbackParams.pop_front();
+		if( surface ) {
+			sendSurface( surface.get(), &params, surface );
+		}
+		if( wait ) {
+			break;
+		}
+	}
+}
+
+bool CinderNDISender::checkConnections()
+{
+	if( ! hasConnections() ) {
+		return false;
+	}
+	// Check to see if we have received any connection metadata from the receiver side
+	NDIConnectionMeta rcvMeta;
+	if( NDIlib_send_capture( mNDISender, &rcvMeta, 0 ) ) {
+		CI_LOG_I( "Got meta from receiver: " << rcvMeta.p_data );
+		NDIlib_send_free_metadata( mNDISender, &rcvMeta );
+	}
+	return true;
+}
+
+ci::Surface8uRef CinderNDISender::copySurface( const ci::Surface& surface )
+{
+	auto copy = mSurfacePool->acquire( surface.getWidth(), surface.getHeight(), surface.getChannelOrder() );
+	copy->copyFrom( surface, surface.getBounds() );
+	return copy;
+}
+
+bool CinderNDISender::skipOffAirFrame()
+{
+	if( ! isReducingQuality() ) {
+		// The first frame after going off air is always sent.
+		mOffAirFrameIndex = 0;
+		return false;
+	}
+	const int interval = std::max( mSenderDescription.mOffAirFrameInterval, 1 );
+	if( mOffAirFrameIndex++ % interval == 0 ) {
+		return false;
+	}
+	++mNumOffAirFramesSkipped;
+	return true;
+}
+
+ci::Surface8uRef CinderNDISender::downscaleOffAir( const ci::Surface& surface )
+{
+	auto start = std::chrono::steady_clock::now();
+	ci::Surface8uRef downscaled;
+	const ci::Surface* src = &surface;
+	for( int step = 0; step < mSenderDescription.mOffAirDownscale && src->getWidth() >= 2 && src->getHeight() >= 2; ++step ) {
+		auto half = mSurfacePool->acquire( src->getWidth() / 2, src->getHeight() / 2, src->getChannelOrder() );
+		downscaleNDISurfaceByHalf( *src, half.get() );
+		// The previous step's surface goes back to the pool.
+		downscaled = half;
+		src = downscaled.get();
+	}
+	if( downscaled ) {
+		mDownscaleHistogram.record( std::chrono::steady_clock::now() - start );
+	}
+	return downscaled;
+}
+
+void CinderNDISender::queueVideoJob( VideoJob&& job )
+{
+	VideoJob dropped;
+	{
+		std::unique_lock<std::mutex> lock( mQueueMutex );
+		const size_t capacity = std::max<size_t>( mSenderDescription.mVideoQueueSize, 1 );
+		if( ! mSenderDescription.mThreaded ) {
+			// Only converting on the worker, the previous surface has to be done with by the time this returns.
+			mQueueCondition.wait( lock, [this] { return mVideoJobs.empty() && ! mVideoJobBusy; } );
+		}
+		else if( mSenderDescription.mQueuePolicy == BLOCK ) {
+			mQueueCondition.wait( lock, [this, capacity] { return mVideoJobs.size() < capacity; } );
+		}
+		while( mVideoJobs.size() >= capacity ) {
+			dropped = std::move( mVideoJobs.front() );
+			mVideoJobs.pop_front();
+			++mNumVideoFramesDropped;
 		}
-		auto videoFrame = createVideoFrameFromSurface( surface, videoFrameParams );	
+		job.mQueueTime = std::chrono::steady_clock::now();
+		mVideoJobs.push_back( std::move( job ) );
+	}
+	mQueueCondition.notify_all();
+}
+
+void CinderNDISender::sendThread()
+{
+	while( true ) {
+		std::unique_lock<std::mutex> lock( mQueueMutex );
+		mQueueCondition.wait( lock, [this] { return ! mVideoJobs.empty() || mSendThreadExiting; } );
+		if( mSendThreadExiting ) {
+			break;
+		}
+		VideoJob job = std::move( mVideoJobs.front() );
+		mVideoJobs.pop_front();
+		mVideoJobBusy = true;
+		lock.unlock();
+		mQueueCondition.notify_all();
+
+		mVideoQueueResidenceHistogram.record( std::chrono::steady_clock::now() - job.mQueueTime );
+		sendVideoJob( job );
+		job = VideoJob();
+
+		lock.lock();
+		mVideoJobBusy = false;
+		lock.unlock();
+		mQueueCondition.notify_all();
+	}
+}
+
+void CinderNDISender::audioSendThread()
+{
+	while( true ) {
+		std::unique_lock<std::mutex> lock( mQueueMutex );
+		mQueueCondition.wait( lock, [this] { return ! mAudioJobs.empty() || mSendThreadExiting; } );
+		if( mSendThreadExiting ) {
+			break;
+		}
+		AudioJobPtr job = std::move( mAudioJobs.front() );
+		mAudioJobs.pop_front();
+		lock.unlock();
+		mQueueCondition.notify_all();
+		sendAudioFrame( &job->mBuffer, &job->mParams );
+		lock.lock();
+		mFreeAudioJobs.push_back( std::move( job ) );
+	}
+}
+
+void CinderNDISender::sendVideoJob( VideoJob& job )
+{
+	// Connections were already checked by the caller unless threaded.
+	if( mSenderDescription.mThreaded && ! checkConnections() ) {
+		return;
+	}
+	ci::Surface* surface = job.mSurface;
+	std::lock_guard<std::mutex> frameLock( mConvertedFrameMutex );
+	// The SDK may read the frame's metadata until the next send, so the parameters live with the sent frame.
+	auto& frame = nextConvertedFrame();
+	frame.mParams = job.mParams;
+	if( ! mEncoder || surface->getWidth() % 2 != 0 ) {
+		auto videoFrame = createVideoFrameFromSurface( surface, &frame.mParams );
 		if( videoFrame.p_data != nullptr ) {
-			NDIlib_send_send_video_async_v2( mNDISender, &videoFrame );
-			//NDIlib_send_send_video_v2( mNDISender, &videoFrame );
+			sendVideoAsync( videoFrame, job.mSurfaceRef );
 		}
+		return;
+	}
+
+	const int width = surface->getWidth();
+	const int height = surface->getHeight();
+	const bool hasAlpha = mSenderDescription.mVideoFormat == UYVA && surface->hasAlpha();
+	const size_t uyvySize = size_t( width ) * height * 2;
+	const size_t size = uyvySize + ( hasAlpha ? size_t( width ) * height : 0 );
+	if( frame.mData.size() < size ) {
+		frame.mData.resize( size );
+	}
+	auto start = std::chrono::steady_clock::now();
+	mEncoder->encode( *surface, frame.mData.data(), width * 2, hasAlpha ? frame.mData.data() + uyvySize : nullptr, width );
+	mConversionHistogram.record( std::chrono::steady_clock::now() - start );
+	++mNumFramesConverted;
+	const float aspectRatio = surface->getAspectRatio();
+	// Pooled surfaces go back to the pool as soon as they are converted.
+	job.mSurfaceRef.reset();
+
+	NDIVideoFrame videoFrame = {
+		width,
+		height,
+		hasAlpha ? NDIlib_FourCC_type_UYVA : NDIlib_FourCC_type_UYVY,
+		frame.mParams.mFrameRateNumerator,
+		frame.mParams.mFrameRateDenomenator,
+		aspectRatio,
+		getNDIFrameType( frame.mParams.mFrameType ),
+		frame.mParams.mTimecode,
+		frame.mData.data(),
+		width * 2,
+		frame.mParams.mMetadata.empty() ? nullptr : frame.mParams.mMetadata.c_str(),
+		-1
+	};
+	sendVideoAsync( videoFrame, nullptr );
+}
+
+void CinderNDISender::sendVideoAsync( const NDIVideoFrame& videoFrame, const ci::Surface8uRef& surface )
+{
+	// Dropped outside of the lock, recycling it into the pool locks the pool.
+	ci::Surface8uRef released;
+	{
+		std::lock_guard<std::mutex> lock( mSendMutex );
+		auto start = std::chrono::steady_clock::now();
+		NDIlib_send_send_video_async_v2( mNDISender, &videoFrame );
+		mVideoSendHistogram.record( std::chrono::steady_clock::now() - start );
+		// The SDK is done with the previous frame once the next one has been handed over.
+		released = std::move( mSurfaceInFlight );
+		mSurfaceInFlight = surface;
+	}
+}
+
+void CinderNDISender::sendVideoAsync( NDIVideoFrame videoFrame, const ci::Surface8uRef& surface, const std::string& metadata )
+{
+	ci::Surface8uRef released;
+	{
+		std::lock_guard<std::mutex> lock( mSendMutex );
+		// Alternating like the converted frames, the copy from two sends ago has been released by the previous send.
+		auto& inFlight = mMetadataInFlight[mNextMetadataInFlight];
+		mNextMetadataInFlight = ( mNextMetadataInFlight + 1 ) % 2;
+		inFlight = metadata;
+		videoFrame.p_metadata = inFlight.empty() ? nullptr : inFlight.c_str();
+		auto start = std::chrono::steady_clock::now();
+		NDIlib_send_send_video_async_v2( mNDISender, &videoFrame );
+		mVideoSendHistogram.record( std::chrono::steady_clock::now() - start );
+		released = std::move( mSurfaceInFlight );
+		mSurfaceInFlight = surface;
+	}
+}
+
+CinderNDISender::ConvertedFrame& CinderNDISender::nextConvertedFrame()
+{
+	// Alternating between two buffers, the SDK releases the previous one during the next send.
+	auto& frame = mConvertedFrames[mNextConvertedFrame];
+	mNextConvertedFrame = ( mNextConvertedFrame + 1 ) % 2;
+	return frame;
+}
+
+void CinderNDISender::sendFrame( const PlanarFrame& frame, const VideoFrameParams* videoFrameParams )
+{
+	if( ! mNDISender || ! frame.mPlanes[0] || ! frame.mPlanes[1] || ( frame.mFormat != NV12 && ! frame.mPlanes[2] ) )
+		return;
+	if( frame.mWidth <= 0 || frame.mHeight <= 0 || frame.mWidth % 2 != 0 || frame.mHeight % 2 != 0 ) {
+		CI_LOG_E( "Planar frames need an even resolution, got " << frame.mWidth << "x" << frame.mHeight );
+		return;
 	}
+
+	mFps = videoFrameParams != nullptr ? float( videoFrameParams->mFrameRateNumerator ) / float( videoFrameParams->mFrameRateDenomenator ) : DEFAULT_FPS;
+
+	if( ! hasConnections() || skipOffAirFrame() )
+		return;
+
+	// Frames queued before this one go out first.
+	{
+		std::unique_lock<std::mutex> lock( mQueueMutex );
+		mQueueCondition.wait( lock, [this] { return mVideoJobs.empty() && ! mVideoJobBusy; } );
+	}
+	// Only keeps the sender thread from taking a converted frame meanwhile, queueing and audio carry on.
+	std::lock_guard<std::mutex> frameLock( mConvertedFrameMutex );
+	auto& sent = nextConvertedFrame();
+	sent.mParams = videoFrameParams != nullptr ? *videoFrameParams : VideoFrameParams();
+	// Planar frames are not downscaled off air, only sent less often.
+	if( isReducingQuality() ) {
+		sent.mParams.mFrameRateDenomenator *= std::max( mSenderDescription.mOffAirFrameInterval, 1 );
+	}
+
+	const int chromaRows = frame.mHeight / 2;
+	const int chromaBytes = frame.mFormat == NV12 ? frame.mWidth : frame.mWidth / 2;
+	const int numChromaPlanes = frame.mFormat == NV12 ? 1 : 2;
+	const uint8_t* data = frame.mPlanes[0];
+	int stride = frame.mStrides[0];
+	// Layout the SDK expects for a luma stride.
+	auto isContiguous = [&] {
+		const int chromaStride = frame.mFormat == NV12 ? stride : stride / 2;
+		const uint8_t* expected = data + size_t( stride ) * frame.mHeight;
+		for( int plane = 1; plane <= numChromaPlanes; ++plane ) {
+			if( frame.mPlanes[plane] != expected || frame.mStrides[plane] != chromaStride ) {
+				return false;
+			}
+			expected += size_t( chromaStride ) * chromaRows;
+		}
+		return stride % 2 == 0;
+	};
+	if( ! isContiguous() ) {
+		stride = frame.mWidth;
+		const size_t lumaSize = size_t( frame.mWidth ) * frame.mHeight;
+		const size_t chromaSize = size_t( chromaBytes ) * chromaRows;
+		sent.mData.resize( lumaSize + chromaSize * numChromaPlanes );
+		uint8_t* dst = sent.mData.data();
+		for( int row = 0; row < frame.mHeight; ++row ) {
+			std::memcpy( dst + row * frame.mWidth, frame.mPlanes[0] + row * frame.mStrides[0], frame.mWidth );
+		}
+		for( int plane = 1; plane <= numChromaPlanes; ++plane ) {
+			uint8_t* planeDst = dst + lumaSize + chromaSize * ( plane - 1 );
+			for( int row = 0; row < chromaRows; ++row ) {
+				std::memcpy( planeDst + row * chromaBytes, frame.mPlanes[plane] + row * frame.mStrides[plane], chromaBytes );
+			}
+		}
+		data = dst;
+		++mNumPlanarFramesCopied;
+	}
+
+	NDIVideoFrame videoFrame = {
+		frame.mWidth,
+		frame.mHeight,
+		getNDIFourCC( frame.mFormat ),
+		sent.mParams.mFrameRateNumerator,
+		sent.mParams.mFrameRateDenomenator,
+		float( frame.mWidth ) / float( frame.mHeight ),
+		getNDIFrameType( sent.mParams.mFrameType ),
+		sent.mParams.mTimecode,
+		const_cast<uint8_t*>( data ),
+		stride,
+		sent.mParams.mMetadata.empty() ? nullptr : sent.mParams.mMetadata.c_str(),
+		-1
+	};
+	sendVideoAsync( videoFrame, nullptr );
+}
+
+NDIlib_FourCC_type_e CinderNDISender::getNDIFourCC( PlanarFormat format )
+{
+	switch( format ) {
+		case I420:
+		{
+			return NDIlib_FourCC_type_I420;
+		}
+		case YV12:
+		{
+			return NDIlib_FourCC_type_YV12;
+		}
+		default:
+		{
+			return NDIlib_FourCC_type_NV12;
+		}
+	}
+}
+
+void CinderNDISender::connectionThread()
+{
+	while( ! mConnectionThreadExiting ) {
+		mNumConnections = NDIlib_send_get_no_connections( mNDISender, 0 );
+		// Doubles as the wait between polls, returning early as soon as the tally changes.
+		NDIlib_tally_t tally;
+		NDIlib_send_get_tally( mNDISender, &tally, mSenderDescription.mConnectionPollInterval );
+		mOnProgram = tally.on_program;
+		mOnPreview = tally.on_preview;
+	}
+}
+
+void CinderNDISender::update()
+{
+	const int numConnections = mNumConnections;
+	if( numConnections != mNumConnectionsEmitted ) {
+		mNumConnectionsEmitted = numConnections;
+		mConnectionsChanged.emit( numConnections );
+	}
+	const Tally tally = getTally();
+	if( tally.mOnProgram != mTallyEmitted.mOnProgram || tally.mOnPreview != mTallyEmitted.mOnPreview ) {
+		mTallyEmitted = tally;
+		mTallyChanged.emit( tally );
+	}
+}
+
+ci::signals::Signal<void( int )>& CinderNDISender::getSignalConnectionsChanged()
+{
+	return mConnectionsChanged;
+}
+
+CinderNDISender::Tally CinderNDISender::getTally() const
+{
+	Tally tally;
+	tally.mOnProgram = mOnProgram;
+	tally.mOnPreview = mOnPreview;
+	return tally;
+}
+
+bool CinderNDISender::isReducingQuality() const
+{
+	return mSenderDescription.mAdaptToTally && hasConnections() && ! mOnProgram && ! mOnPreview;
+}
+
+ci::signals::Signal<void( const CinderNDISender::Tally& )>& CinderNDISender::getSignalTallyChanged()
+{
+	return mTallyChanged;
+}
+
+CinderNDISender::Stats CinderNDISender::getStats() const
+{
+	Stats stats;
+	stats.mNumFramesConverted = mNumFramesConverted;
+	stats.mNumPlanarFramesCopied = mNumPlanarFramesCopied;
+	stats.mNumSurfacesAllocated = mSurfacePool->getNumMisses();
+	stats.mNumVideoFramesDropped = mNumVideoFramesDropped;
+	stats.mNumAudioFramesDropped = mNumAudioFramesDropped;
+	stats.mNumOffAirFramesSkipped = mNumOffAirFramesSkipped;
+	{
+		std::lock_guard<std::mutex> lock( mQueueMutex );
+		stats.mVideoQueueDepth = mVideoJobs.size();
+		stats.mAudioQueueDepth = mAudioJobs.size();
+	}
+	stats.mConversion = mConversionHistogram.getSummary();
+	stats.mVideoQueueResidence = mVideoQueueResidenceHistogram.getSummary();
+	stats.mVideoSend = mVideoSendHistogram.getSummary();
+	stats.mAudioSend = mAudioSendHistogram.getSummary();
+	stats.mReadbackStall = mPboReader->getStallSummary();
+	stats.mReadbackCopy = mPboReader->getCopySummary();
+	stats.mOffAirDownscale = mDownscaleHistogram.getSummary();
+	return stats;
+}
+
+void CinderNDISender::resetStats()
+{
+	mNumFramesConverted = 0;
+	mNumPlanarFramesCopied = 0;
+	mNumVideoFramesDropped = 0;
+	mNumAudioFramesDropped = 0;
+	mNumOffAirFramesSkipped = 0;
+	mConversionHistogram.reset();
+	mVideoQueueResidenceHistogram.reset();
+	mVideoSendHistogram.reset();
+	mAudioSendHistogram.reset();
+	mDownscaleHistogram.reset();
+	mPboReader->resetStats();
 }
 
 NDIFrameType CinderNDISender::getNDIFrameType( FrameType frameType )
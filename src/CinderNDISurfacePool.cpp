@@ -0,0 +1,106 @@
+#include "CinderNDISurfacePool.h"
+#include <tuple>
+
+bool CinderNDISurfacePool::Key::operator<( const Key& other ) const
+{
+	return std::tie( mWidth, mHeight, mChannelOrder ) < std::tie( other.mWidth, other.mHeight, other.mChannelOrder );
+}
+
+bool CinderNDISurfacePool::Key::operator==( const Key& other ) const
+{
+	return mWidth == other.mWidth && mHeight == other.mHeight && mChannelOrder == other.mChannelOrder;
+}
+
+CinderNDISurfacePoolRef CinderNDISurfacePool::create( size_t rowAlignment )
+{
+	return CinderNDISurfacePoolRef( new CinderNDISurfacePool( rowAlignment ) );
+}
+
+CinderNDISurfacePool::CinderNDISurfacePool( size_t rowAlignment )
+: mRowAlignment( rowAlignment )
+{
+}
+
+ci::Surface8uRef CinderNDISurfacePool::allocate( int width, int height, ci::SurfaceChannelOrder channelOrder ) const
+{
+	if( mRowAlignment == 0 ) {
+		return ci::Surface8u::create( width, height, true, channelOrder );
+	}
+	const size_t rowBytes = ( size_t( width ) * channelOrder.getImagePixelInc() + mRowAlignment - 1 ) / mRowAlignment * mRowAlignment;
+	std::shared_ptr<uint8_t> storage( new uint8_t[ rowBytes * height + mRowAlignment ], std::default_delete<uint8_t[]>() );
+	uint8_t* data = storage.get() + ( mRowAlignment - reinterpret_cast<uintptr_t>( storage.get() ) % mRowAlignment ) % mRowAlignment;
+	return ci::Surface8uRef( new ci::Surface8u( data, width, height, static_cast<ptrdiff_t>( rowBytes ), channelOrder ), [ storage ] ( ci::Surface8u* surface ) {
+		delete surface;
+	} );
+}
+
+ci::Surface8uRef CinderNDISurfacePool::acquire( int width, int height, ci::SurfaceChannelOrder channelOrder )
+{
+	const Key key{ width, height, channelOrder.getCode() };
+	ci::Surface8uRef master;
+	bool keyChanged = false;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( key != mActiveKey ) {
+			mActiveKey = key;
+			keyChanged = true;
+		}
+		auto& idle = mIdleSurfaces[ key ];
+		if( ! idle.empty() ) {
+			master = std::move( idle.back() );
+			idle.pop_back();
+		}
+	}
+	if( keyChanged ) {
+		trim( key );
+	}
+	if( master ) {
+		++mNumHits;
+	}
+	else {
+		++mNumMisses;
+		master = allocate( width, height, channelOrder );
+	}
+	std::weak_ptr<CinderNDISurfacePool> weakPool = shared_from_this();
+	auto* surface = master.get();
+	return ci::Surface8uRef( surface, [ weakPool, key, master ] ( ci::Surface8u* ) {
+		if( auto pool = weakPool.lock() ) {
+			pool->recycle( key, master );
+		}
+	} );
+}
+
+void CinderNDISurfacePool::recycle( const Key& key, const ci::Surface8uRef& surface )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	if( key == mActiveKey ) {
+		mIdleSurfaces[ key ].push_back( surface );
+	}
+}
+
+void CinderNDISurfacePool::trim( const Key& keep )
+{
+	std::map<Key, std::vector<ci::Surface8uRef>> stale;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		for( auto idleIt = mIdleSurfaces.begin(); idleIt != mIdleSurfaces.end(); ) {
+			if( idleIt->first != keep ) {
+				stale.insert( std::move( *idleIt ) );
+				idleIt = mIdleSurfaces.erase( idleIt );
+			}
+			else {
+				++idleIt;
+			}
+		}
+	}
+}
+
+size_t CinderNDISurfacePool::getNumIdle() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	size_t numIdle = 0;
+	for( const auto& idle : mIdleSurfaces ) {
+		numIdle += idle.second.size();
+	}
+	return numIdle;
+}
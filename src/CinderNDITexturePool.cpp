@@ -0,0 +1,119 @@
+#include "CinderNDITexturePool.h"
+#include <tuple>
+#include "cinder/gl/Context.h"
+#include "cinder/app/AppBase.h"
+
+bool CinderNDITexturePool::Key::operator<( const Key& other ) const
+{
+	return std::tie( mWidth, mHeight, mInternalFormat ) < std::tie( other.mWidth, other.mHeight, other.mInternalFormat );
+}
+
+bool CinderNDITexturePool::Key::operator==( const Key& other ) const
+{
+	return mWidth == other.mWidth && mHeight == other.mHeight && mInternalFormat == other.mInternalFormat;
+}
+
+CinderNDITexturePoolRef CinderNDITexturePool::create()
+{
+	return CinderNDITexturePoolRef( new CinderNDITexturePool() );
+}
+
+ci::gl::TextureRef CinderNDITexturePool::acquire( int width, int height, GLint internalFormat )
+{
+	const Key key{ width, height, internalFormat };
+	ci::gl::TextureRef master;
+	ci::gl::SyncRef fence;
+	bool keyChanged = false;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( key != mActiveKey ) {
+			mActiveKey = key;
+			keyChanged = true;
+		}
+		auto& idle = mIdleTextures[ key ];
+		// Oldest first, its fence is the most likely to have signaled already.
+		if( ! idle.empty() ) {
+			master = std::move( idle.front().mTexture );
+			fence = std::move( idle.front().mFence );
+			idle.pop_front();
+		}
+	}
+	if( keyChanged ) {
+		trim( key );
+	}
+	if( master ) {
+		++mNumHits;
+		// A server side wait, uploads issued after this on the current context are ordered after the draws of the
+		// releasing context without blocking this thread.
+		if( fence ) {
+			fence->waitSync();
+		}
+	}
+	else {
+		++mNumMisses;
+		master = ci::gl::Texture2d::create( width, height, ci::gl::Texture2d::Format().internalFormat( internalFormat ).mipmap( false ).minFilter( GL_LINEAR ).magFilter( GL_LINEAR ) );
+		// NDI frames start with the top row.
+		master->setTopDown( true );
+	}
+	// Hand out an alias that keeps the master alive and returns it to the pool when the last reference goes away.
+	std::weak_ptr<CinderNDITexturePool> weakPool = shared_from_this();
+	auto* tex = master.get();
+	return ci::gl::TextureRef( tex, [ weakPool, key, master ] ( ci::gl::Texture2d* ) {
+		auto pool = weakPool.lock();
+		if( ! pool ) {
+			return;
+		}
+		if( ci::gl::context() ) {
+			pool->recycle( key, master );
+		}
+		else if( auto app = ci::app::AppBase::get() ) {
+			// Released on a thread without GL, the fence has to be placed by the thread that draws.
+			app->dispatchAsync( [ weakPool, key, master ] {
+				if( auto pool = weakPool.lock() ) {
+					pool->recycle( key, master );
+				}
+			} );
+		}
+		// Without an app nothing can tell when the GPU is done with the texture, it is let go instead of reused.
+	} );
+}
+
+void CinderNDITexturePool::recycle( const Key& key, const ci::gl::TextureRef& tex )
+{
+	auto fence = ci::gl::Sync::create();
+	// Other contexts only see the fence once it has been flushed.
+	glFlush();
+	std::lock_guard<std::mutex> lock( mMutex );
+	// Stale textures are not kept, the master reference is released together with the deleter.
+	if( key == mActiveKey ) {
+		mIdleTextures[ key ].push_back( { tex, fence } );
+	}
+}
+
+void CinderNDITexturePool::trim( const Key& keep )
+{
+	std::map<Key, std::deque<Idle>> stale;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		for( auto idleIt = mIdleTextures.begin(); idleIt != mIdleTextures.end(); ) {
+			if( idleIt->first != keep ) {
+				stale.insert( std::move( *idleIt ) );
+				idleIt = mIdleTextures.erase( idleIt );
+			}
+			else {
+				++idleIt;
+			}
+		}
+	}
+	// Stale textures are released here, outside of the lock.
+}
+
+size_t CinderNDITexturePool::getNumIdle() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	size_t numIdle = 0;
+	for( const auto& idle : mIdleTextures ) {
+		numIdle += idle.second.size();
+	}
+	return numIdle;
+}
@@ -0,0 +1,431 @@
+#include "CinderNDIUYVYEncoder.h"
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#include <emmintrin.h>
+	#define CINDER_NDI_ENCODER_SSE2
+	// AVX2 is compiled per function and picked at runtime, builds do not need to target it.
+	#if defined( __GNUC__ ) || defined( __clang__ )
+		#include <immintrin.h>
+		#define CINDER_NDI_ENCODER_AVX2
+		#define CINDER_NDI_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+	#elif defined( _MSC_VER )
+		#include <immintrin.h>
+		#include <intrin.h>
+		#define CINDER_NDI_ENCODER_AVX2
+		#define CINDER_NDI_TARGET_AVX2
+	#endif
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#include <arm_neon.h>
+	#define CINDER_NDI_ENCODER_NEON
+#endif
+
+namespace {
+
+// Fixed point BT.601 / BT.709 coefficients scaled by 256, already including the video range scale.
+// Chroma rows sum to zero so grey stays exactly at 128.
+struct Coefficients {
+	int16_t mYR, mYG, mYB;
+	int16_t mUR, mUG, mUB;
+	int16_t mVR, mVG, mVB;
+};
+
+const Coefficients BT601_COEFFICIENTS = { 66, 129, 25, -38, -74, 112, 112, -94, -18 };
+const Coefficients BT709_COEFFICIENTS = { 47, 157, 16, -26, -86, 112, 112, -102, -10 };
+
+// Byte offsets of the channels within a pixel. mA is -1 if the source has no alpha.
+struct Offsets {
+	int mR, mG, mB, mA;
+};
+
+inline uint8_t clampByte( int value )
+{
+	return static_cast<uint8_t>( value < 0 ? 0 : ( value > 255 ? 255 : value ) );
+}
+
+// Reference for every other kernel, all of them use the same integer math and rounding.
+void encodeRowScalar( const uint8_t* src, int pixelInc, int begin, int end, const Offsets& offsets, const Coefficients& c, uint8_t* dst, uint8_t* alpha )
+{
+	for( int x = begin; x < end; x += 2 ) {
+		const uint8_t* p0 = src + x * pixelInc;
+		const uint8_t* p1 = p0 + pixelInc;
+		const int r0 = p0[offsets.mR], g0 = p0[offsets.mG], b0 = p0[offsets.mB];
+		const int r1 = p1[offsets.mR], g1 = p1[offsets.mG], b1 = p1[offsets.mB];
+		const int r = ( r0 + r1 + 1 ) >> 1, g = ( g0 + g1 + 1 ) >> 1, b = ( b0 + b1 + 1 ) >> 1;
+		uint8_t* out = dst + x * 2;
+		out[0] = clampByte( ( ( c.mUR * r + c.mUG * g + c.mUB * b + 128 ) >> 8 ) + 128 );
+		out[1] = clampByte( ( ( c.mYR * r0 + c.mYG * g0 + c.mYB * b0 + 128 ) >> 8 ) + 16 );
+		out[2] = clampByte( ( ( c.mVR * r + c.mVG * g + c.mVB * b + 128 ) >> 8 ) + 128 );
+		out[3] = clampByte( ( ( c.mYR * r1 + c.mYG * g1 + c.mYB * b1 + 128 ) >> 8 ) + 16 );
+		if( alpha ) {
+			alpha[x] = p0[offsets.mA];
+			alpha[x + 1] = p1[offsets.mA];
+		}
+	}
+}
+
+// SIMD kernels take 4 byte pixels and return the number of pixels they converted, the scalar kernel finishes the row.
+
+#if defined( CINDER_NDI_ENCODER_SSE2 )
+
+// 16 bit lanes of one channel of 8 pixels.
+inline __m128i channelSSE2( __m128i lo, __m128i hi, int offset )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	const __m128i shift = _mm_cvtsi32_si128( offset * 8 );
+	return _mm_packs_epi32( _mm_and_si128( _mm_srl_epi32( lo, shift ), mask ), _mm_and_si128( _mm_srl_epi32( hi, shift ), mask ) );
+}
+
+// Rounded average of neighbouring lanes, 8 pixels of a and 8 of b give 8 chroma samples.
+inline __m128i pairAverageSSE2( __m128i a, __m128i b )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFFFF );
+	const __m128i avgA = _mm_avg_epu16( _mm_and_si128( a, mask ), _mm_srli_epi32( a, 16 ) );
+	const __m128i avgB = _mm_avg_epu16( _mm_and_si128( b, mask ), _mm_srli_epi32( b, 16 ) );
+	return _mm_packs_epi32( avgA, avgB );
+}
+
+inline __m128i lumaSSE2( __m128i r, __m128i g, __m128i b, const Coefficients& c )
+{
+	__m128i sum = _mm_mullo_epi16( r, _mm_set1_epi16( c.mYR ) );
+	sum = _mm_add_epi16( sum, _mm_mullo_epi16( g, _mm_set1_epi16( c.mYG ) ) );
+	sum = _mm_add_epi16( sum, _mm_mullo_epi16( b, _mm_set1_epi16( c.mYB ) ) );
+	sum = _mm_add_epi16( sum, _mm_set1_epi16( 128 ) );
+	return _mm_add_epi16( _mm_srli_epi16( sum, 8 ), _mm_set1_epi16( 16 ) );
+}
+
+inline __m128i chromaSSE2( __m128i r, __m128i g, __m128i b, int16_t cr, int16_t cg, int16_t cb )
+{
+	__m128i sum = _mm_mullo_epi16( r, _mm_set1_epi16( cr ) );
+	sum = _mm_add_epi16( sum, _mm_mullo_epi16( g, _mm_set1_epi16( cg ) ) );
+	sum = _mm_add_epi16( sum, _mm_mullo_epi16( b, _mm_set1_epi16( cb ) ) );
+	sum = _mm_add_epi16( sum, _mm_set1_epi16( 128 ) );
+	return _mm_add_epi16( _mm_srai_epi16( sum, 8 ), _mm_set1_epi16( 128 ) );
+}
+
+int encodeRowSSE2( const uint8_t* src, int width, const Offsets& offsets, const Coefficients& c, uint8_t* dst, uint8_t* alpha )
+{
+	int x = 0;
+	for( ; x + 16 <= width; x += 16 ) {
+		const __m128i* in = reinterpret_cast<const __m128i*>( src + x * 4 );
+		const __m128i p0 = _mm_loadu_si128( in );
+		const __m128i p1 = _mm_loadu_si128( in + 1 );
+		const __m128i p2 = _mm_loadu_si128( in + 2 );
+		const __m128i p3 = _mm_loadu_si128( in + 3 );
+		const __m128i r0 = channelSSE2( p0, p1, offsets.mR ), r1 = channelSSE2( p2, p3, offsets.mR );
+		const __m128i g0 = channelSSE2( p0, p1, offsets.mG ), g1 = channelSSE2( p2, p3, offsets.mG );
+		const __m128i b0 = channelSSE2( p0, p1, offsets.mB ), b1 = channelSSE2( p2, p3, offsets.mB );
+
+		const __m128i y = _mm_packus_epi16( lumaSSE2( r0, g0, b0, c ), lumaSSE2( r1, g1, b1, c ) );
+		const __m128i r = pairAverageSSE2( r0, r1 ), g = pairAverageSSE2( g0, g1 ), b = pairAverageSSE2( b0, b1 );
+		// U0..U7 V0..V7, then interleaved into U0 V0 U1 V1 ..
+		const __m128i uv = _mm_packus_epi16( chromaSSE2( r, g, b, c.mUR, c.mUG, c.mUB ), chromaSSE2( r, g, b, c.mVR, c.mVG, c.mVB ) );
+		const __m128i uvInterleaved = _mm_unpacklo_epi8( uv, _mm_srli_si128( uv, 8 ) );
+		__m128i* out = reinterpret_cast<__m128i*>( dst + x * 2 );
+		_mm_storeu_si128( out, _mm_unpacklo_epi8( uvInterleaved, y ) );
+		_mm_storeu_si128( out + 1, _mm_unpackhi_epi8( uvInterleaved, y ) );
+		if( alpha ) {
+			const __m128i a = _mm_packus_epi16( channelSSE2( p0, p1, offsets.mA ), channelSSE2( p2, p3, offsets.mA ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( alpha + x ), a );
+		}
+	}
+	return x;
+}
+
+#endif
+
+#if defined( CINDER_NDI_ENCODER_AVX2 )
+
+// Same steps as the SSE2 kernel. Every 128 bit lane works on its own run of 16 pixels since packs and unpacks
+// do not cross lanes, so the low lane holds pixels 0..15 and the high lane pixels 16..31.
+
+CINDER_NDI_TARGET_AVX2 inline __m256i loadLanesAVX2( const uint8_t* src, int block )
+{
+	const __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src ) + block );
+	const __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + 64 ) + block );
+	return _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+}
+
+CINDER_NDI_TARGET_AVX2 inline __m256i channelAVX2( __m256i lo, __m256i hi, int offset )
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFF );
+	const __m128i shift = _mm_cvtsi32_si128( offset * 8 );
+	return _mm256_packs_epi32( _mm256_and_si256( _mm256_srl_epi32( lo, shift ), mask ), _mm256_and_si256( _mm256_srl_epi32( hi, shift ), mask ) );
+}
+
+CINDER_NDI_TARGET_AVX2 inline __m256i pairAverageAVX2( __m256i a, __m256i b )
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFFFF );
+	const __m256i avgA = _mm256_avg_epu16( _mm256_and_si256( a, mask ), _mm256_srli_epi32( a, 16 ) );
+	const __m256i avgB = _mm256_avg_epu16( _mm256_and_si256( b, mask ), _mm256_srli_epi32( b, 16 ) );
+	return _mm256_packs_epi32( avgA, avgB );
+}
+
+CINDER_NDI_TARGET_AVX2 inline __m256i lumaAVX2( __m256i r, __m256i g, __m256i b, const Coefficients& c )
+{
+	__m256i sum = _mm256_mullo_epi16( r, _mm256_set1_epi16( c.mYR ) );
+	sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( g, _mm256_set1_epi16( c.mYG ) ) );
+	sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( b, _mm256_set1_epi16( c.mYB ) ) );
+	sum = _mm256_add_epi16( sum, _mm256_set1_epi16( 128 ) );
+	return _mm256_add_epi16( _mm256_srli_epi16( sum, 8 ), _mm256_set1_epi16( 16 ) );
+}
+
+CINDER_NDI_TARGET_AVX2 inline __m256i chromaAVX2( __m256i r, __m256i g, __m256i b, int16_t cr, int16_t cg, int16_t cb )
+{
+	__m256i sum = _mm256_mullo_epi16( r, _mm256_set1_epi16( cr ) );
+	sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( g, _mm256_set1_epi16( cg ) ) );
+	sum = _mm256_add_epi16( sum, _mm256_mullo_epi16( b, _mm256_set1_epi16( cb ) ) );
+	sum = _mm256_add_epi16( sum, _mm256_set1_epi16( 128 ) );
+	return _mm256_add_epi16( _mm256_srai_epi16( sum, 8 ), _mm256_set1_epi16( 128 ) );
+}
+
+CINDER_NDI_TARGET_AVX2 int encodeRowAVX2( const uint8_t* src, int width, const Offsets& offsets, const Coefficients& c, uint8_t* dst, uint8_t* alpha )
+{
+	int x = 0;
+	for( ; x + 32 <= width; x += 32 ) {
+		const uint8_t* in = src + x * 4;
+		const __m256i p0 = loadLanesAVX2( in, 0 );
+		const __m256i p1 = loadLanesAVX2( in, 1 );
+		const __m256i p2 = loadLanesAVX2( in, 2 );
+		const __m256i p3 = loadLanesAVX2( in, 3 );
+		const __m256i r0 = channelAVX2( p0, p1, offsets.mR ), r1 = channelAVX2( p2, p3, offsets.mR );
+		const __m256i g0 = channelAVX2( p0, p1, offsets.mG ), g1 = channelAVX2( p2, p3, offsets.mG );
+		const __m256i b0 = channelAVX2( p0, p1, offsets.mB ), b1 = channelAVX2( p2, p3, offsets.mB );
+
+		const __m256i y = _mm256_packus_epi16( lumaAVX2( r0, g0, b0, c ), lumaAVX2( r1, g1, b1, c ) );
+		const __m256i r = pairAverageAVX2( r0, r1 ), g = pairAverageAVX2( g0, g1 ), b = pairAverageAVX2( b0, b1 );
+		const __m256i uv = _mm256_packus_epi16( chromaAVX2( r, g, b, c.mUR, c.mUG, c.mUB ), chromaAVX2( r, g, b, c.mVR, c.mVG, c.mVB ) );
+		const __m256i uvInterleaved = _mm256_unpacklo_epi8( uv, _mm256_srli_si256( uv, 8 ) );
+		const __m256i lo = _mm256_unpacklo_epi8( uvInterleaved, y );
+		const __m256i hi = _mm256_unpackhi_epi8( uvInterleaved, y );
+		__m256i* out = reinterpret_cast<__m256i*>( dst + x * 2 );
+		_mm256_storeu_si256( out, _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+		_mm256_storeu_si256( out + 1, _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+		if( alpha ) {
+			const __m256i a = _mm256_packus_epi16( channelAVX2( p0, p1, offsets.mA ), channelAVX2( p2, p3, offsets.mA ) );
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( alpha + x ), a );
+		}
+	}
+	return x;
+}
+
+bool isAVX2Supported()
+{
+#if defined( _MSC_VER ) && ! defined( __clang__ )
+	int info[4];
+	__cpuid( info, 1 );
+	const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	const bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+	if( ! osxsave || ! avx || ( _xgetbv( 0 ) & 6 ) != 6 ) {
+		return false;
+	}
+	__cpuidex( info, 7, 0 );
+	return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+#endif
+
+#if defined( CINDER_NDI_ENCODER_NEON )
+
+inline uint8x8_t lumaNEON( uint8x8_t r, uint8x8_t g, uint8x8_t b, const Coefficients& c )
+{
+	uint16x8_t sum = vmull_u8( r, vdup_n_u8( static_cast<uint8_t>( c.mYR ) ) );
+	sum = vmlal_u8( sum, g, vdup_n_u8( static_cast<uint8_t>( c.mYG ) ) );
+	sum = vmlal_u8( sum, b, vdup_n_u8( static_cast<uint8_t>( c.mYB ) ) );
+	sum = vshrq_n_u16( vaddq_u16( sum, vdupq_n_u16( 128 ) ), 8 );
+	return vmovn_u16( vaddq_u16( sum, vdupq_n_u16( 16 ) ) );
+}
+
+inline uint8x8_t chromaNEON( int16x8_t r, int16x8_t g, int16x8_t b, int16_t cr, int16_t cg, int16_t cb )
+{
+	int16x8_t sum = vmulq_n_s16( r, cr );
+	sum = vmlaq_n_s16( sum, g, cg );
+	sum = vmlaq_n_s16( sum, b, cb );
+	sum = vshrq_n_s16( vaddq_s16( sum, vdupq_n_s16( 128 ) ), 8 );
+	return vqmovun_s16( vaddq_s16( sum, vdupq_n_s16( 128 ) ) );
+}
+
+// Rounded average of neighbouring pixels.
+inline int16x8_t pairAverageNEON( uint8x16_t v )
+{
+	return vreinterpretq_s16_u16( vrshrq_n_u16( vpaddlq_u8( v ), 1 ) );
+}
+
+int encodeRowNEON( const uint8_t* src, int width, const Offsets& offsets, const Coefficients& c, uint8_t* dst, uint8_t* alpha )
+{
+	int x = 0;
+	for( ; x + 16 <= width; x += 16 ) {
+		const uint8x16x4_t p = vld4q_u8( src + x * 4 );
+		const uint8x16_t r = p.val[offsets.mR], g = p.val[offsets.mG], b = p.val[offsets.mB];
+		const uint8x8_t yLo = lumaNEON( vget_low_u8( r ), vget_low_u8( g ), vget_low_u8( b ), c );
+		const uint8x8_t yHi = lumaNEON( vget_high_u8( r ), vget_high_u8( g ), vget_high_u8( b ), c );
+		const uint8x8x2_t y = vuzp_u8( yLo, yHi );
+		const int16x8_t rAvg = pairAverageNEON( r ), gAvg = pairAverageNEON( g ), bAvg = pairAverageNEON( b );
+		uint8x8x4_t out;
+		out.val[0] = chromaNEON( rAvg, gAvg, bAvg, c.mUR, c.mUG, c.mUB );
+		out.val[1] = y.val[0];
+		out.val[2] = chromaNEON( rAvg, gAvg, bAvg, c.mVR, c.mVG, c.mVB );
+		out.val[3] = y.val[1];
+		vst4_u8( dst + x * 2, out );
+		if( alpha ) {
+			vst1q_u8( alpha + x, p.val[offsets.mA] );
+		}
+	}
+	return x;
+}
+
+#endif
+
+} // anonymous namespace
+
+CinderNDIUYVYEncoder::CinderNDIUYVYEncoder( CinderNDIYUVDecoder::ColorSpace colorSpace, Kernel kernel )
+: mColorSpace( colorSpace ), mKernel( kernel )
+{
+	if( mKernel == KERNEL_AUTO || ! isKernelSupported( mKernel ) ) {
+		if( isKernelSupported( KERNEL_AVX2 ) ) {
+			mKernel = KERNEL_AVX2;
+		}
+		else if( isKernelSupported( KERNEL_SSE2 ) ) {
+			mKernel = KERNEL_SSE2;
+		}
+		else if( isKernelSupported( KERNEL_NEON ) ) {
+			mKernel = KERNEL_NEON;
+		}
+		else {
+			mKernel = KERNEL_SCALAR;
+		}
+	}
+}
+
+bool CinderNDIUYVYEncoder::isKernelSupported( Kernel kernel )
+{
+	switch( kernel ) {
+		case KERNEL_SCALAR:
+		{
+			return true;
+		}
+		case KERNEL_SSE2:
+		{
+#if defined( CINDER_NDI_ENCODER_SSE2 )
+			return true;
+#else
+			return false;
+#endif
+		}
+		case KERNEL_AVX2:
+		{
+#if defined( CINDER_NDI_ENCODER_AVX2 )
+			static const bool supported = isAVX2Supported();
+			return supported;
+#else
+			return false;
+#endif
+		}
+		case KERNEL_NEON:
+		{
+#if defined( CINDER_NDI_ENCODER_NEON )
+			return true;
+#else
+			return false;
+#endif
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+const char* CinderNDIUYVYEncoder::getKernelName( Kernel kernel )
+{
+	switch( kernel ) {
+		case KERNEL_SCALAR:
+		{
+			return "scalar";
+		}
+		case KERNEL_SSE2:
+		{
+			return "SSE2";
+		}
+		case KERNEL_AVX2:
+		{
+			return "AVX2";
+		}
+		case KERNEL_NEON:
+		{
+			return "NEON";
+		}
+		default:
+		{
+			return "auto";
+		}
+	}
+}
+
+void CinderNDIUYVYEncoder::encode( const ci::Surface8u& surface, uint8_t* dst, int dstRowBytes, uint8_t* alpha, int alphaRowBytes ) const
+{
+	encode( surface.getData(), static_cast<int>( surface.getRowBytes() ), surface.getChannelOrder(), surface.getWidth(), surface.getHeight(), dst, dstRowBytes, alpha, alphaRowBytes );
+}
+
+void CinderNDIUYVYEncoder::encode( const uint8_t* src, int srcRowBytes, const ci::SurfaceChannelOrder& channelOrder, int width, int height,
+								   uint8_t* dst, int dstRowBytes, uint8_t* alpha, int alphaRowBytes ) const
+{
+	if( ! src || ! dst || width < 2 ) {
+		return;
+	}
+	width &= ~1;
+	auto colorSpace = mColorSpace;
+	if( colorSpace == CinderNDIYUVDecoder::AUTO ) {
+		colorSpace = height < 720 ? CinderNDIYUVDecoder::BT601 : CinderNDIYUVDecoder::BT709;
+	}
+	const Coefficients& coefficients = colorSpace == CinderNDIYUVDecoder::BT601 ? BT601_COEFFICIENTS : BT709_COEFFICIENTS;
+	const int pixelInc = channelOrder.getImagePixelInc();
+	const Offsets offsets = { channelOrder.getRedOffset(), channelOrder.getGreenOffset(), channelOrder.getBlueOffset(), channelOrder.hasAlpha() ? static_cast<int>( channelOrder.getAlphaOffset() ) : -1 };
+	// Without an alpha channel the plane is opaque and only needs filling once.
+	uint8_t* alphaRows = offsets.mA >= 0 ? alpha : nullptr;
+	if( alpha && ! alphaRows ) {
+		for( int row = 0; row < height; ++row ) {
+			std::memset( alpha + row * alphaRowBytes, 255, width );
+		}
+	}
+
+	for( int row = 0; row < height; ++row ) {
+		const uint8_t* srcRow = src + row * srcRowBytes;
+		uint8_t* dstRow = dst + row * dstRowBytes;
+		uint8_t* alphaRow = alphaRows ? alphaRows + row * alphaRowBytes : nullptr;
+		int converted = 0;
+		if( pixelInc == 4 ) {
+			switch( mKernel ) {
+#if defined( CINDER_NDI_ENCODER_AVX2 )
+				case KERNEL_AVX2:
+				{
+					converted = encodeRowAVX2( srcRow, width, offsets, coefficients, dstRow, alphaRow );
+					break;
+				}
+#endif
+#if defined( CINDER_NDI_ENCODER_SSE2 )
+				case KERNEL_SSE2:
+				{
+					converted = encodeRowSSE2( srcRow, width, offsets, coefficients, dstRow, alphaRow );
+					break;
+				}
+#endif
+#if defined( CINDER_NDI_ENCODER_NEON )
+				case KERNEL_NEON:
+				{
+					converted = encodeRowNEON( srcRow, width, offsets, coefficients, dstRow, alphaRow );
+					break;
+				}
+#endif
+				default:
+				{
+					break;
+				}
+			}
+		}
+		encodeRowScalar( srcRow, pixelInc, converted, width, offsets, coefficients, dstRow, alphaRow );
+	}
+}
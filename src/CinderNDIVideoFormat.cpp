@@ -0,0 +1,160 @@
+#include "CinderNDIVideoFormat.h"
+#include "cinder/gl/scoped.h"
+#include "cinder/gl/draw.h"
+
+namespace {
+
+#if defined( CINDER_GL_ES )
+const char* GLSL_VERSION = "#version 300 es\nprecision highp float;\nprecision highp int;\n";
+#else
+const char* GLSL_VERSION = "#version 150\n";
+#endif
+
+const char* UYVY_VERT = R"(
+uniform mat4 ciModelViewProjection;
+in vec4 ciPosition;
+in vec2 ciTexCoord0;
+out vec2 vTexCoord;
+void main()
+{
+	vTexCoord = ciTexCoord0;
+	gl_Position = ciModelViewProjection * ciPosition;
+}
+)";
+
+// Texture coordinates are normalized frame coordinates with the top row at 0.
+// Each texel holds U Y0 V Y1 for two neighbouring pixels, values are in video range.
+const char* UYVY_FRAG = R"(
+uniform sampler2D uTex;
+uniform ivec2 uFrameSize;
+uniform vec4 uCoeffs; // V->R, U->G, V->G, U->B
+uniform int uHasAlpha;
+in vec2 vTexCoord;
+out vec4 oColor;
+void main()
+{
+	ivec2 pixel = clamp( ivec2( vTexCoord * vec2( uFrameSize ) ), ivec2( 0 ), uFrameSize - ivec2( 1 ) );
+	vec4 uyvy = texelFetch( uTex, ivec2( pixel.x / 2, pixel.y ), 0 );
+	float luma = ( pixel.x % 2 == 0 ) ? uyvy.g : uyvy.a;
+	float y = ( luma * 255.0 - 16.0 ) / 219.0;
+	float u = ( uyvy.r * 255.0 - 128.0 ) / 224.0;
+	float v = ( uyvy.b * 255.0 - 128.0 ) / 224.0;
+	vec3 rgb = vec3( y + uCoeffs.x * v, y - uCoeffs.y * u - uCoeffs.z * v, y + uCoeffs.w * u );
+	float alpha = 1.0;
+	if( uHasAlpha != 0 ) {
+		// Alpha rows are xres bytes wide and packed two per texel row below the UYVY rows.
+		int offset = ( pixel.y % 2 ) * uFrameSize.x + pixel.x;
+		vec4 packed = texelFetch( uTex, ivec2( offset / 4, uFrameSize.y + pixel.y / 2 ), 0 );
+		alpha = packed[ offset % 4 ];
+	}
+	oColor = vec4( clamp( rgb, 0.0, 1.0 ), alpha );
+}
+)";
+
+} // anonymous namespace
+
+bool isNDIFourCCYUV( NDIlib_FourCC_type_e fourCC )
+{
+	return fourCC == NDIlib_FourCC_type_UYVY || fourCC == NDIlib_FourCC_type_UYVA;
+}
+
+bool getNDITextureLayout( const NDIlib_video_frame_v2_t& videoFrame, CinderNDITextureLayout* layout )
+{
+	switch( videoFrame.FourCC ) {
+		case NDIlib_FourCC_type_RGBA:
+		case NDIlib_FourCC_type_RGBX:
+		{
+			// Uploading into an RGB texture makes the undefined X channel sample as opaque.
+			*layout = { videoFrame.xres, videoFrame.yres, GL_RGBA, videoFrame.FourCC == NDIlib_FourCC_type_RGBX ? GL_RGB8 : GL_RGBA8 };
+			return true;
+		}
+		case NDIlib_FourCC_type_BGRA:
+		case NDIlib_FourCC_type_BGRX:
+		{
+			*layout = { videoFrame.xres, videoFrame.yres, GL_BGRA, videoFrame.FourCC == NDIlib_FourCC_type_BGRX ? GL_RGB8 : GL_RGBA8 };
+			return true;
+		}
+		case NDIlib_FourCC_type_UYVY:
+		{
+			*layout = { videoFrame.xres / 2, videoFrame.yres, GL_RGBA, GL_RGBA8 };
+			return true;
+		}
+		case NDIlib_FourCC_type_UYVA:
+		{
+			// The alpha plane fills half a texel row per frame row. With an odd height its last row would be half empty,
+			// rounding down loses it and rounding up reads past the end of the frame.
+			if( videoFrame.yres % 2 != 0 ) {
+				return false;
+			}
+			*layout = { videoFrame.xres / 2, videoFrame.yres + videoFrame.yres / 2, GL_RGBA, GL_RGBA8 };
+			return true;
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+ci::SurfaceChannelOrder getNDISurfaceChannelOrder( NDIlib_FourCC_type_e fourCC )
+{
+	switch( fourCC ) {
+		case NDIlib_FourCC_type_BGRA:
+		{
+			return ci::SurfaceChannelOrder::BGRA;
+		}
+		case NDIlib_FourCC_type_BGRX:
+		{
+			return ci::SurfaceChannelOrder::BGRX;
+		}
+		case NDIlib_FourCC_type_RGBX:
+		{
+			return ci::SurfaceChannelOrder::RGBX;
+		}
+		default:
+		{
+			return ci::SurfaceChannelOrder::RGBA;
+		}
+	}
+}
+
+CinderNDIYUVDecoder::CinderNDIYUVDecoder( ColorSpace colorSpace )
+: mColorSpace( colorSpace )
+{
+	mGlsl = ci::gl::GlslProg::create( ci::gl::GlslProg::Format()
+		.vertex( std::string( GLSL_VERSION ) + UYVY_VERT )
+		.fragment( std::string( GLSL_VERSION ) + UYVY_FRAG )
+	);
+	mGlsl->uniform( "uTex", 0 );
+}
+
+void CinderNDIYUVDecoder::setUniforms( NDIlib_FourCC_type_e fourCC, const ci::ivec2& frameSize )
+{
+	auto colorSpace = mColorSpace;
+	if( colorSpace == AUTO ) {
+		colorSpace = frameSize.y < 720 ? BT601 : BT709;
+	}
+	if( colorSpace == BT601 ) {
+		mGlsl->uniform( "uCoeffs", ci::vec4( 1.402f, 0.344136f, 0.714136f, 1.772f ) );
+	}
+	else {
+		mGlsl->uniform( "uCoeffs", ci::vec4( 1.5748f, 0.187324f, 0.468124f, 1.8556f ) );
+	}
+	mGlsl->uniform( "uFrameSize", frameSize );
+	mGlsl->uniform( "uHasAlpha", fourCC == NDIlib_FourCC_type_UYVA ? 1 : 0 );
+}
+
+void CinderNDIYUVDecoder::draw( const ci::gl::TextureRef& tex, NDIlib_FourCC_type_e fourCC, const ci::ivec2& frameSize, const ci::Rectf& dstRect )
+{
+	if( ! tex ) {
+		return;
+	}
+	if( ! isNDIFourCCYUV( fourCC ) ) {
+		ci::gl::draw( tex, dstRect );
+		return;
+	}
+	ci::gl::ScopedGlslProg scopedGlsl( mGlsl );
+	ci::gl::ScopedTextureBind scopedTex( tex, 0 );
+	setUniforms( fourCC, frameSize );
+	ci::gl::drawSolidRect( dstRect, ci::vec2( 0.0f, 0.0f ), ci::vec2( 1.0f, 1.0f ) );
+}
@@ -0,0 +1,55 @@
+#include "CinderNDIVideoFrame.h"
+#include <chrono>
+
+CinderNDIVideoFrame::CinderNDIVideoFrame( const CinderNDIVideoFrameTrackerRef& tracker, const NDIlib_video_frame_v2_t& videoFrame )
+: mTracker( tracker )
+, mVideoFrame( videoFrame )
+{
+}
+
+CinderNDIVideoFrame::~CinderNDIVideoFrame()
+{
+	mTracker->release( mVideoFrame );
+}
+
+CinderNDIVideoFrameTracker::CinderNDIVideoFrameTracker( const NDIReceiverInstanceRef& receiverInstance, size_t maxFramesInFlight )
+: mReceiverInstance( receiverInstance )
+, mMaxFramesInFlight( std::max<size_t>( maxFramesInFlight, 1 ) )
+{
+}
+
+bool CinderNDIVideoFrameTracker::waitForCapacity( uint32_t timeoutInMs )
+{
+	if( mNumFramesInFlight < mMaxFramesInFlight ) {
+		return true;
+	}
+	std::unique_lock<std::mutex> lock( mMutex );
+	return mCapacityCond.wait_for( lock, std::chrono::milliseconds( timeoutInMs ), [ this ] {
+		return mCanceled || mNumFramesInFlight < mMaxFramesInFlight;
+	} ) && ! mCanceled;
+}
+
+NDIVideoFrameRef CinderNDIVideoFrameTracker::adopt( const NDIlib_video_frame_v2_t& videoFrame )
+{
+	++mNumFramesInFlight;
+	return NDIVideoFrameRef( new CinderNDIVideoFrame( shared_from_this(), videoFrame ) );
+}
+
+void CinderNDIVideoFrameTracker::release( const NDIlib_video_frame_v2_t& videoFrame )
+{
+	NDIlib_recv_free_video_v2( mReceiverInstance.get(), &videoFrame );
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		--mNumFramesInFlight;
+	}
+	mCapacityCond.notify_all();
+}
+
+void CinderNDIVideoFrameTracker::cancel()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mCanceled = true;
+	}
+	mCapacityCond.notify_all();
+}
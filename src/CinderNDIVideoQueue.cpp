@@ -0,0 +1,60 @@
+#include "CinderNDIVideoQueue.h"
+
+CinderNDIVideoQueue::CinderNDIVideoQueue( const Format& format )
+: mFormat( format )
+{
+}
+
+void CinderNDIVideoQueue::push( const CinderNDIVideoQueueEntry& entry )
+{
+	// Dropped entries are released outside of the lock, they might return textures or SDK buffers.
+	std::deque<Item> dropped;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		const size_t depth = mFormat.mPolicy == MAILBOX ? 1 : std::max<size_t>( mFormat.mDepth, 1 );
+		while( mItems.size() >= depth ) {
+			dropped.push_back( std::move( mItems.front() ) );
+			mItems.pop_front();
+		}
+		mItems.push_back( { entry, Clock::now() } );
+	}
+	mNumDropped += dropped.size();
+}
+
+bool CinderNDIVideoQueue::pop( CinderNDIVideoQueueEntry* entry )
+{
+	std::deque<Item> dropped;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( mFormat.mPolicy == MAX_AGE ) {
+			const auto now = Clock::now();
+			const auto maxAge = std::chrono::duration<float, std::milli>( mFormat.mMaxAge );
+			// Always keep the newest frame, even when it is stale, so the consumer does not run dry.
+			while( mItems.size() > 1 && now - mItems.front().mQueuedTime > maxAge ) {
+				dropped.push_back( std::move( mItems.front() ) );
+				mItems.pop_front();
+			}
+		}
+		if( mItems.empty() ) {
+			return false;
+		}
+		mResidence.record( Clock::now() - mItems.front().mQueuedTime );
+		*entry = std::move( mItems.front().mEntry );
+		mItems.pop_front();
+	}
+	mNumDropped += dropped.size();
+	return true;
+}
+
+void CinderNDIVideoQueue::clear()
+{
+	std::deque<Item> dropped;
+	std::lock_guard<std::mutex> lock( mMutex );
+	std::swap( dropped, mItems );
+}
+
+size_t CinderNDIVideoQueue::getDepth() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mItems.size();
+}